@@ -0,0 +1,569 @@
+/*
+# Copyright (c) 2008 Chung Shin Yee <cshinyee@gmail.com>
+#
+#       http://github.com/xman
+#       http://myxman.org
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License as
+# published by the Free Software Foundation; either version 2 of the
+# License, or (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+# USA.
+#
+# The GNU General Public License is contained in the file COPYING.
+#
+*/
+
+// The Aho-Corasick algorithm for matching many patterns at once.
+
+#ifndef AHOCORASICK_H
+#define AHOCORASICK_H
+
+#include <cassert>
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace algorithm
+{
+    /// \brief The layout of the transitions of an AhoCorasick automaton.
+    typedef enum {
+        AHOCORASICK_DENSE, ///< A complete DFA with a row of transitions per state, one lookup per byte.
+        AHOCORASICK_DOUBLE_ARRAY ///< The trie in a double array, with failure links followed at scan time.
+    } AhoCorasickLayout;
+
+    /// \brief An Aho-Corasick automaton scanning a stream of bytes for every occurrence of a
+    ///        set of patterns in a single pass.<br>
+    ///        The failure links of kmp_setup() are generalized from a pattern to the trie of
+    ///        all the patterns. Like KmpMatcher, the text is fed in chunks of explicit length
+    ///        and the state is carried from one chunk to the next.
+    class AhoCorasick
+    {
+    public:
+        AhoCorasick(void);
+        ~AhoCorasick(void);
+
+        /// \brief Add a pattern to the set.
+        /// \param[in] pattern The pattern string, which may contain NUL bytes.
+        /// \param[in] length The length of the pattern string.
+        /// \return The index of the pattern, counting from 0 in the order of addition.
+        /// \warning The automaton must be built again before scanning.
+        long add(const char* pattern, long length);
+
+        /// \brief Get the number of patterns added.
+        long patterns(void) const;
+
+        /// \brief Build the automaton, choosing the dense layout when its table is small enough.
+        void build(void);
+
+        /// \brief Build the automaton with the given layout of transitions.
+        void build(AhoCorasickLayout layout);
+
+        /// \brief Get the layout of the automaton built.
+        AhoCorasickLayout layout(void) const;
+
+        /// \brief Go back to the start of a stream.
+        void reset(void);
+
+        /// \brief Get the number of bytes scanned since the start of the stream.
+        long position(void) const;
+
+        /// \brief Scan the next chunk of the stream and report every occurrence of every
+        ///        pattern ending in it.
+        /// \param F The type of a function or function object called as report(offset, pattern).
+        /// \param[in] text The bytes of the chunk.
+        /// \param[in] length The number of bytes of the chunk.
+        /// \param[in] report Called with the stream offset where an occurrence begins and the
+        ///            index of its pattern, by increasing end offset.
+        /// \return The number of occurrences reported.
+        template <typename F>
+        long scan(const char* text, long length, F report);
+
+    private:
+        /// \brief Find the child of the trie node \b node labelled \b byte.
+        /// \return The child node, -1 if there is none.
+        long child(long node, unsigned char byte) const;
+
+        /// \brief Find the child of the trie node \b node labelled \b byte among the edges
+        ///        of every node sorted by label, the edges of \b node starting at first_edge[node].
+        /// \return The child node, -1 if there is none.
+        static long child(const std::vector<std::pair<unsigned char, long> >& edges,
+                          const std::vector<long>& first_edge, long node, unsigned char byte);
+
+        void build_dense(const std::vector<long>& order);
+        void build_double_array(const std::vector<long>& order);
+        void add_double_array_slots(long count, std::vector<long>& next_free, std::vector<long>& prev_free);
+
+        /// \brief Report the patterns ending at the state \b state, which has some.
+        template <typename F>
+        long report_state(long state, long end, F& report) const;
+
+        template <typename F>
+        long scan_dense(const char* text, long length, F& report);
+
+        template <typename F>
+        long scan_double_array(const char* text, long length, F& report);
+
+        // The trie, built by add(). Node 0 is the root.
+        std::vector<long> m_first_child; ///< The first child of each node, -1 if none.
+        std::vector<long> m_next_sibling; ///< The next child of the parent of each node, -1 if none.
+        std::vector<unsigned char> m_label; ///< The byte on the edge from the parent of each node.
+        std::vector<long> m_terminal; ///< The last pattern added ending at each node, -1 if none.
+        std::vector<long> m_length; ///< The length of each pattern.
+        std::vector<long> m_same; ///< The previous pattern added equal to each pattern, -1 if none.
+
+        // The automaton, built by build().
+        AhoCorasickLayout m_layout; ///< The layout of the transitions.
+        long m_classes; ///< The number of byte classes: the bytes in no pattern share class 0.
+        std::vector<int> m_class; ///< The class of each byte.
+        std::vector<int> m_delta; ///< The dense transitions to the row of the target, complemented if it reports.
+        std::vector<int> m_base; ///< The double array offset of the children of each state.
+        std::vector<int> m_check; ///< The parent of each double array slot, -1 if free.
+        std::vector<int> m_fail; ///< The failure link of each double array state.
+        std::vector<long> m_output; ///< The last pattern ending at each state, -1 if none.
+        std::vector<long> m_dict; ///< The state reached by failure links reporting first, -1 if none.
+        std::vector<long> m_reports; ///< The state itself if it reports, m_dict otherwise.
+
+        long m_state; ///< The state at the end of the stream.
+        long m_position; ///< The number of bytes scanned.
+    };
+} // namespace algorithm
+
+
+// ===================================================================
+// Implementation
+// ===================================================================
+
+namespace algorithm
+{
+    /// The dense layout is chosen when its table has at most this number of transitions.
+    static const long aho_corasick_dense_max = 1L << 20;
+
+
+    inline AhoCorasick::AhoCorasick(void) :
+        m_first_child(1, -1), m_next_sibling(1, -1), m_label(1, 0), m_terminal(1, -1),
+        m_length(), m_same(), m_layout(AHOCORASICK_DENSE), m_classes(1), m_class(256, 0),
+        m_delta(1, 0), m_base(), m_check(), m_fail(), m_output(1, -1), m_dict(1, -1), m_reports(1, -1),
+        m_state(0), m_position(0)
+    {
+    }
+
+
+    inline AhoCorasick::~AhoCorasick(void)
+    {
+    }
+
+
+    inline long AhoCorasick::add(const char* pattern, long length)
+    {
+        assert(length > 0);
+
+        long node = 0;
+        for (long i = 0; i < length; i++) {
+            unsigned char byte = static_cast<unsigned char>(pattern[i]);
+            long next = child(node, byte);
+            if (next < 0) {
+                next = static_cast<long>(m_label.size());
+                m_first_child.push_back(-1);
+                m_next_sibling.push_back(m_first_child[node]);
+                m_label.push_back(byte);
+                m_terminal.push_back(-1);
+                m_first_child[node] = next;
+            }
+            node = next;
+        }
+
+        long id = static_cast<long>(m_length.size());
+        m_length.push_back(length);
+        m_same.push_back(m_terminal[node]);
+        m_terminal[node] = id;
+        return id;
+    }
+
+
+    inline long AhoCorasick::patterns(void) const
+    {
+        return static_cast<long>(m_length.size());
+    }
+
+
+    inline void AhoCorasick::build(void)
+    {
+        long nclasses = 1;
+        std::vector<char> used(256, 0);
+        for (size_t n = 1; n < m_label.size(); n++) {
+            if (!used[m_label[n]]) {
+                used[m_label[n]] = 1;
+                nclasses++;
+            }
+        }
+
+        long nodes = static_cast<long>(m_label.size());
+        build(nodes * nclasses <= aho_corasick_dense_max ? AHOCORASICK_DENSE : AHOCORASICK_DOUBLE_ARRAY);
+    }
+
+
+    /// The nodes are visited in breadth-first order, so the failure link of a node, which
+    /// is shallower, is set before it: the failure link of a child of \b u labelled \b c is
+    /// the child labelled \b c of the deepest node on the failure chain of \b u having one,
+    /// as in kmp_setup().
+    /// \par References:
+    /// \li A. V. Aho and M. J. Corasick. Efficient String Matching: An Aid to Bibliographic
+    ///     Search. Communications of the ACM, 18(6), 1975.
+    inline void AhoCorasick::build(AhoCorasickLayout layout)
+    {
+        long nodes = static_cast<long>(m_label.size());
+        assert(nodes < 0x7fffffffL);
+
+        // Number the bytes occurring in the patterns from 1, the others are all class 0.
+        std::fill(m_class.begin(), m_class.end(), 0);
+        m_classes = 1;
+        for (long n = 1; n < nodes; n++) {
+            if (m_class[m_label[n]] == 0) {
+                m_class[m_label[n]] = static_cast<int>(m_classes++);
+            }
+        }
+
+        // The failure links follow transitions of nodes with up to 256 children: sort the
+        // edges of every node so that each is a binary search rather than a walk of the siblings.
+        std::vector<long> first_edge(nodes + 1, 0);
+        std::vector<std::pair<unsigned char, long> > edges;
+        edges.reserve(nodes);
+        for (long u = 0; u < nodes; u++) {
+            first_edge[u] = static_cast<long>(edges.size());
+            for (long v = m_first_child[u]; v >= 0; v = m_next_sibling[v]) {
+                edges.push_back(std::make_pair(m_label[v], v));
+            }
+            std::sort(edges.begin() + first_edge[u], edges.end());
+        }
+        first_edge[nodes] = static_cast<long>(edges.size());
+
+        std::vector<long> order(1, 0);
+        std::vector<long> fail(nodes, 0);
+        for (size_t i = 0; i < order.size(); i++) {
+            long u = order[i];
+            for (long v = m_first_child[u]; v >= 0; v = m_next_sibling[v]) {
+                order.push_back(v);
+                if (u == 0) {
+                    continue;
+                }
+                long f = fail[u];
+                long g = child(edges, first_edge, f, m_label[v]);
+                while (g < 0 && f != 0) {
+                    f = fail[f];
+                    g = child(edges, first_edge, f, m_label[v]);
+                }
+                fail[v] = (g >= 0) ? g : 0;
+            }
+        }
+
+        // The trie nodes are the states of the dense layout; build_double_array() renumbers them.
+        m_output.assign(m_terminal.begin(), m_terminal.end());
+        m_dict.assign(nodes, -1);
+        m_fail.assign(fail.begin(), fail.end());
+        for (long i = 1; i < nodes; i++) {
+            long v = order[i];
+            long f = fail[v];
+            m_dict[v] = (m_output[f] >= 0) ? f : m_dict[f];
+        }
+        m_reports.resize(nodes);
+        for (long v = 0; v < nodes; v++) {
+            m_reports[v] = (m_output[v] >= 0) ? v : m_dict[v];
+        }
+
+        m_layout = layout;
+        if (layout == AHOCORASICK_DENSE) {
+            build_dense(order);
+        } else {
+            build_double_array(order);
+        }
+        reset();
+    }
+
+
+    inline AhoCorasickLayout AhoCorasick::layout(void) const
+    {
+        return m_layout;
+    }
+
+
+    inline void AhoCorasick::reset(void)
+    {
+        m_state = 0;
+        m_position = 0;
+    }
+
+
+    inline long AhoCorasick::position(void) const
+    {
+        return m_position;
+    }
+
+
+    template <typename F>
+    long AhoCorasick::scan(const char* text, long length, F report)
+    {
+        assert(length >= 0);
+
+        if (m_layout == AHOCORASICK_DENSE) {
+            return scan_dense(text, length, report);
+        }
+        return scan_double_array(text, length, report);
+    }
+
+
+    inline long AhoCorasick::child(long node, unsigned char byte) const
+    {
+        long v = m_first_child[node];
+        while (v >= 0 && m_label[v] != byte) {
+            v = m_next_sibling[v];
+        }
+        return v;
+    }
+
+
+    inline long AhoCorasick::child(const std::vector<std::pair<unsigned char, long> >& edges,
+                                   const std::vector<long>& first_edge, long node, unsigned char byte)
+    {
+        std::vector<std::pair<unsigned char, long> >::const_iterator end = edges.begin() + first_edge[node+1];
+        std::vector<std::pair<unsigned char, long> >::const_iterator e =
+            std::lower_bound(edges.begin() + first_edge[node], end, std::make_pair(byte, 0L));
+        return (e != end && e->first == byte) ? e->second : -1;
+    }
+
+
+    /// A row of m_classes transitions per state: the missing transitions of a state are those
+    /// of its failure link, whose row is complete by then. A transition holds the offset of
+    /// the row of its target rather than its index, which takes a multiplication off the
+    /// dependency chain of the scan, and is complemented when the target reports some
+    /// pattern, so the scan tests for a report without another lookup.
+    inline void AhoCorasick::build_dense(const std::vector<long>& order)
+    {
+        long nodes = static_cast<long>(order.size());
+        long width = m_classes;
+
+        assert(nodes * width < 0x7fffffffL);
+
+        m_delta.assign(nodes * width, 0);
+        for (long i = 0; i < nodes; i++) {
+            long u = order[i];
+            int* row = &m_delta[u * width];
+            if (u != 0) {
+                const int* frow = &m_delta[m_fail[u] * width];
+                std::copy(frow, frow + width, row);
+            }
+            for (long v = m_first_child[u]; v >= 0; v = m_next_sibling[v]) {
+                int target = static_cast<int>(v * width);
+                row[m_class[m_label[v]]] = (m_reports[v] >= 0) ? ~target : target;
+            }
+        }
+        m_base.clear();
+        m_check.clear();
+    }
+
+
+    /// The children of a state \b s are at m_base[s] + class, and a slot belongs to \b s when
+    /// its m_check is \b s. The children of each state are placed at the first offset where
+    /// all their slots are free, so the array is nearly full and its size is close to the
+    /// number of states rather than states times classes.<br>
+    /// The free slots are kept in a doubly linked list and only they are tried for the
+    /// smallest class, so the occupied slots are never scanned again and the build time
+    /// stays close to linear in the number of states.
+    /// \par References:
+    /// \li J. Aoe. An Efficient Digital Search Algorithm by Using a Double-Array Structure.
+    ///     IEEE Transactions on Software Engineering, 15(9), 1989.
+    /// \li S. Yata, M. Oono, K. Morita, M. Fuketa, T. Sumitomo and J. Aoe. A Compact
+    ///     Static Double-Array Keeping Character Codes. Information Processing & Management,
+    ///     43(1), 2007.
+    inline void AhoCorasick::build_double_array(const std::vector<long>& order)
+    {
+        long nodes = static_cast<long>(order.size());
+        long width = m_classes;
+        std::vector<long> slot(nodes, 0);
+        std::vector<int> classes;
+
+        // Slot 0 is the root; the classes are at least 1, so no child lands there. It is
+        // also the head of the circular list of free slots.
+        m_base.clear();
+        m_check.clear();
+        std::vector<long> next_free;
+        std::vector<long> prev_free;
+        add_double_array_slots(nodes + width, next_free, prev_free);
+        m_check[0] = -2;
+
+        for (long i = 0; i < nodes; i++) {
+            long u = order[i];
+            classes.clear();
+            for (long v = m_first_child[u]; v >= 0; v = m_next_sibling[v]) {
+                classes.push_back(m_class[m_label[v]]);
+            }
+            if (classes.empty()) {
+                continue;
+            }
+            std::sort(classes.begin(), classes.end());
+
+            long base;
+            for (long f = next_free[0]; ; f = next_free[f]) {
+                if (f == 0) {
+                    // Every free slot was tried: the new slots past the end all fit.
+                    f = static_cast<long>(m_check.size());
+                    add_double_array_slots(width, next_free, prev_free);
+                }
+                base = f - classes[0];
+                if (base < 0) {
+                    continue;
+                }
+                if (base + width > static_cast<long>(m_check.size())) {
+                    add_double_array_slots(base + width - static_cast<long>(m_check.size()),
+                                           next_free, prev_free);
+                }
+                size_t j = 1;
+                while (j < classes.size() && m_check[base + classes[j]] == -1) {
+                    j++;
+                }
+                if (j == classes.size()) {
+                    break;
+                }
+            }
+
+            m_base[slot[u]] = static_cast<int>(base);
+            for (long v = m_first_child[u]; v >= 0; v = m_next_sibling[v]) {
+                long s = base + m_class[m_label[v]];
+                slot[v] = s;
+                m_check[s] = static_cast<int>(slot[u]);
+                next_free[prev_free[s]] = next_free[s];
+                prev_free[next_free[s]] = prev_free[s];
+            }
+        }
+
+        // Move the per-state arrays from trie nodes to slots.
+        long slots = static_cast<long>(m_check.size());
+        std::vector<int> fail(slots, 0);
+        std::vector<long> output(slots, -1);
+        std::vector<long> dict(slots, -1);
+        std::vector<long> reports(slots, -1);
+        for (long v = 0; v < nodes; v++) {
+            long s = slot[v];
+            fail[s] = static_cast<int>(slot[m_fail[v]]);
+            output[s] = m_output[v];
+            dict[s] = (m_dict[v] >= 0) ? slot[m_dict[v]] : -1;
+            reports[s] = (m_reports[v] >= 0) ? slot[m_reports[v]] : -1;
+        }
+        m_fail.swap(fail);
+        m_output.swap(output);
+        m_dict.swap(dict);
+        m_reports.swap(reports);
+        m_delta.clear();
+    }
+
+
+    /// Append \b count free slots to the double array and to the end of the free list.
+    inline void AhoCorasick::add_double_array_slots(long count, std::vector<long>& next_free,
+                                                    std::vector<long>& prev_free)
+    {
+        long size = static_cast<long>(m_check.size());
+        m_base.resize(size + count, 0);
+        m_check.resize(size + count, -1);
+        next_free.resize(size + count);
+        prev_free.resize(size + count);
+        if (size == 0) {
+            next_free[0] = 0;
+            prev_free[0] = 0;
+        }
+
+        for (long s = std::max(size, 1L); s < size + count; s++) {
+            long last = prev_free[0];
+            next_free[last] = s;
+            prev_free[s] = last;
+            next_free[s] = 0;
+            prev_free[0] = s;
+        }
+    }
+
+
+    template <typename F>
+    long AhoCorasick::report_state(long state, long end, F& report) const
+    {
+        long found = 0;
+        for (long s = m_reports[state]; s >= 0; s = m_dict[s]) {
+            for (long p = m_output[s]; p >= 0; p = m_same[p]) {
+                report(end - m_length[p], p);
+                found++;
+            }
+        }
+        return found;
+    }
+
+
+    template <typename F>
+    long AhoCorasick::scan_dense(const char* text, long length, F& report)
+    {
+        const int* delta = &m_delta[0];
+        const int* cls = &m_class[0];
+        long width = m_classes;
+        long row = m_state * width;
+        long found = 0;
+
+        for (long j = 0; j < length; j++) {
+            long t = delta[row + cls[static_cast<unsigned char>(text[j])]];
+            if (t < 0) {
+                t = ~t;
+                found += report_state(t / width, m_position + j + 1, report);
+            }
+            row = t;
+        }
+        m_state = row / width;
+        m_position += length;
+        return found;
+    }
+
+
+    /// A byte in no pattern leads back to the root at once; otherwise the failure links are
+    /// followed until a state has a child for the byte, which costs O(1) amortized per byte.
+    template <typename F>
+    long AhoCorasick::scan_double_array(const char* text, long length, F& report)
+    {
+        const int* base = &m_base[0];
+        const int* check = &m_check[0];
+        const int* fail = &m_fail[0];
+        const int* cls = &m_class[0];
+        long s = m_state;
+        long found = 0;
+
+        for (long j = 0; j < length; j++) {
+            int c = cls[static_cast<unsigned char>(text[j])];
+            if (c == 0) {
+                s = 0;
+                continue;
+            }
+            for (;;) {
+                long t = base[s] + c;
+                if (check[t] == s) {
+                    s = t;
+                    break;
+                }
+                if (s == 0) {
+                    break;
+                }
+                s = fail[s];
+            }
+            if (m_reports[s] >= 0) {
+                found += report_state(s, m_position + j + 1, report);
+            }
+        }
+        m_state = s;
+        m_position += length;
+        return found;
+    }
+} // namespace algorithm
+
+#endif // AHOCORASICK_H
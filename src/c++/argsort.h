@@ -0,0 +1,215 @@
+/*
+# Copyright (c) 2008 Chung Shin Yee <cshinyee@gmail.com>
+#
+#       http://github.com/xman
+#       http://myxman.org
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License as
+# published by the Free Software Foundation; either version 2 of the
+# License, or (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+# USA.
+#
+# The GNU General Public License is contained in the file COPYING.
+#
+*/
+
+#ifndef ARGSORT_H
+#define ARGSORT_H
+
+#include <cassert>
+#include "quicksort.h"
+#include "move.h"
+
+namespace algorithm
+{
+    /// \brief A sort key paired with the index of its record.<br>
+    ///        Pairs order by key, then by index, so any sort of them yields the stable order.
+    template <typename K>
+    struct KeyIndex
+    {
+        K key; ///< The sort key.
+        long index; ///< The index of the record holding the key.
+
+        bool operator<(const KeyIndex<K>& rhs) const;
+        bool operator<=(const KeyIndex<K>& rhs) const;
+    };
+
+
+    /// \brief Sort the \b length pairs by key, ties by index.
+    /// \param K The data type of the keys.
+    /// \param[in,out] pairs The pointer to the list of pairs.
+    /// \param[in] length The number of pairs.
+    template <typename K>
+    void arg_sort(KeyIndex<K>* pairs, long length);
+
+    /// \brief Find the permutation sorting the \b length records by a key field, leaving
+    ///        the records untouched.
+    /// \param T The data type of the records.
+    /// \param K The data type of the key field.
+    /// \param[in] data The pointer to the list of records.
+    /// \param[in] length The number of records.
+    /// \param[in] field The key field of the records.
+    /// \param[out] index The indices of the records in stable sorted order.
+    template <typename T, typename K>
+    void arg_sort(const T* data, long length, K T::*field, long* index);
+
+    /// \brief Find the permutation sorting the \b length records by the key returned by
+    ///        \b key, leaving the records untouched.
+    /// \param T The data type of the records.
+    /// \param K The data type of the keys.
+    /// \param[in] data The pointer to the list of records.
+    /// \param[in] length The number of records.
+    /// \param[in] key The function extracting the key of a record.
+    /// \param[out] index The indices of the records in stable sorted order.
+    template <typename T, typename K>
+    void arg_sort(const T* data, long length, K (*key)(const T&), long* index);
+
+    /// \brief Rearrange the records so that the new data[i] is the old data[index[i]].
+    /// \param T The data type of the records.
+    /// \param[in,out] data The pointer to the list of records.
+    /// \param[in] length The number of records.
+    /// \param[in,out] index The permutation, reset to the identity on return.
+    /// \note Every record is moved once, plus one temporary per cycle of the permutation.
+    template <typename T>
+    void apply_permutation(T* data, long length, long* index);
+
+    /// \brief Stable sort of the \b length records by a key field, moving each record once.
+    /// \param T The data type of the records.
+    /// \param K The data type of the key field.
+    /// \param[in,out] data The pointer to the list of records.
+    /// \param[in] length The number of records.
+    /// \param[in] field The key field of the records.
+    template <typename T, typename K>
+    void indirect_sort(T* data, long length, K T::*field);
+} // namespace algorithm
+
+
+// ===================================================================
+// Implementation
+// ===================================================================
+
+namespace algorithm
+{
+    template <typename K>
+    bool KeyIndex<K>::operator<(const KeyIndex<K>& rhs) const
+    {
+        return key < rhs.key || (!(rhs.key < key) && index < rhs.index);
+    }
+
+
+    template <typename K>
+    bool KeyIndex<K>::operator<=(const KeyIndex<K>& rhs) const
+    {
+        return !(rhs < *this);
+    }
+
+
+    /// The pairs are small enough that every swap of the inner sort stays cheap, whatever
+    /// the size of the records they stand for.
+    template <typename K>
+    void arg_sort(KeyIndex<K>* pairs, long length)
+    {
+        assert(length > 0);
+
+        quick_sort(pairs, length);
+    }
+
+
+    template <typename T, typename K>
+    void arg_sort(const T* data, long length, K T::*field, long* index)
+    {
+        assert(length > 0);
+
+        KeyIndex<K>* pairs = new KeyIndex<K>[length];
+        assert(pairs != NULL);
+
+        for (long i = 0; i < length; i++) {
+            pairs[i].key = data[i].*field;
+            pairs[i].index = i;
+        }
+        arg_sort(pairs, length);
+        for (long i = 0; i < length; i++) {
+            index[i] = pairs[i].index;
+        }
+
+        delete[] pairs;
+    }
+
+
+    template <typename T, typename K>
+    void arg_sort(const T* data, long length, K (*key)(const T&), long* index)
+    {
+        assert(length > 0);
+
+        KeyIndex<K>* pairs = new KeyIndex<K>[length];
+        assert(pairs != NULL);
+
+        for (long i = 0; i < length; i++) {
+            pairs[i].key = key(data[i]);
+            pairs[i].index = i;
+        }
+        arg_sort(pairs, length);
+        for (long i = 0; i < length; i++) {
+            index[i] = pairs[i].index;
+        }
+
+        delete[] pairs;
+    }
+
+
+    /// Each cycle i -> index[i] -> index[index[i]] -> ... is rotated by saving data[i],
+    /// pulling every record of the cycle into the slot that wants it, and dropping the saved
+    /// record into the last slot. A slot is marked done by setting index[j] = j.
+    template <typename T>
+    void apply_permutation(T* data, long length, long* index)
+    {
+        assert(length > 0);
+
+        for (long i = 0; i < length; i++) {
+            if (index[i] == i) {
+                continue;
+            }
+
+            T saved = ALGORITHM_MOVE(data[i]);
+            long j = i;
+            for (;;) {
+                long k = index[j];
+                assert(k >= 0 && k < length);
+                index[j] = j;
+                if (k == i) {
+                    break;
+                }
+                data[j] = ALGORITHM_MOVE(data[k]);
+                j = k;
+            }
+            data[j] = ALGORITHM_MOVE(saved);
+        }
+    }
+
+
+    template <typename T, typename K>
+    void indirect_sort(T* data, long length, K T::*field)
+    {
+        assert(length > 0);
+
+        long* index = new long[length];
+        assert(index != NULL);
+
+        arg_sort(data, length, field, index);
+        apply_permutation(data, length, index);
+
+        delete[] index;
+    }
+} // namespace algorithm
+
+#endif // ARGSORT_H
@@ -0,0 +1,234 @@
+/*
+# Copyright (c) 2008 Chung Shin Yee <cshinyee@gmail.com>
+#
+#       http://github.com/xman
+#       http://myxman.org
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License as
+# published by the Free Software Foundation; either version 2 of the
+# License, or (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+# USA.
+#
+# The GNU General Public License is contained in the file COPYING.
+#
+*/
+
+#ifndef BLOCKMERGESORT_H
+#define BLOCKMERGESORT_H
+
+#include <cassert>
+#include <cmath>
+#include <algorithm>
+#include "insertionsort.h"
+#include "sortnetwork.h"
+#include "timsort.h"
+#include "move.h"
+
+namespace algorithm
+{
+    /// \brief Sort the \b length elements using the Block Merge Sort algorithm.
+    /// \param T The data type of the elements.
+    /// \param[in,out] data The pointer to the list of elements.
+    /// \param[in] length The number of elements.
+    /// \note The sort is stable, takes O(n log n) time, and O(sqrt(n)) extra space.
+    template <typename T>
+    void block_merge_sort(T* data, long length);
+
+    /// \brief Sort the elements from \b istart to \b iend using the Block Merge Sort algorithm.
+    /// \param T The data type of the elements.
+    /// \param[in,out] data The pointer to the list of elements.
+    /// \param[in] istart The index of the first elements to sort.
+    /// \param[in] iend The index of the last elements to sort.
+    template <typename T>
+    void block_merge_sort(T* data, long istart, long iend);
+} // namespace algorithm
+
+
+// ===================================================================
+// Implementation
+// ===================================================================
+
+namespace algorithm
+{
+    /// The runs with at most this number of elements are sorted before merging.
+    static const long block_merge_sort_run = 32;
+
+
+    template <typename T>
+    static void block_merge(T* data, long na, long nb, T* buffer, long block, long* tags);
+
+    template <typename T>
+    static void block_merge_select(T* data, long nblocks, long block, long* tags);
+
+
+    template <typename T>
+    void block_merge_sort(T* data, long length)
+    {
+        assert(length > 0);
+
+        block_merge_sort(data, 0, length-1);
+    }
+
+
+    /// Bottom-up merge sort whose merges run in place with a buffer of sqrt(n) elements and
+    /// a tag per block of that size. Runs of block_merge_sort_run elements are sorted first,
+    /// and two runs already in order are left alone.
+    template <typename T>
+    void block_merge_sort(T* data, long istart, long iend)
+    {
+        assert(iend - istart + 1 > 0);
+
+        long length = iend - istart + 1;
+        T* base = data + istart;
+
+        for (long i = 0; i < length; i += block_merge_sort_run) {
+            long n = std::min(block_merge_sort_run, length - i);
+            if (!network_sort_stable(base + i, n)) {
+                insertion_sort(base, i, i + n - 1);
+            }
+        }
+        if (length <= block_merge_sort_run) {
+            return;
+        }
+
+        long block = std::max(block_merge_sort_run,
+                              static_cast<long>(std::sqrt(static_cast<double>(length))) + 1);
+        // The buffer is constructed by moving the first block in and back out, which leaves
+        // assignable elements without requiring a default constructor.
+        T* buffer = allocate_uninitialized<T>(block);
+        uninitialized_move(base, base + block, buffer);
+        move_forward(buffer, buffer + block, base);
+        long* tags = new long[length / block + 1];
+        assert(tags != NULL);
+
+        for (long width = block_merge_sort_run; width < length; width *= 2) {
+            for (long i = 0; i + width < length; i += 2*width) {
+                long nb = std::min(width, length - i - width);
+                if (base[i+width] < base[i+width-1]) {
+                    block_merge(base + i, width, nb, buffer, block, tags);
+                }
+            }
+        }
+
+        delete[] tags;
+        deallocate_uninitialized(buffer, block);
+    }
+
+
+    /// Merge the adjacent sorted runs data[0..na) and data[na..na+nb).
+    /// The runs are cut into blocks of \b block elements, except a short head on the first
+    /// run and a short tail on the second, and the blocks are sorted by their first element,
+    /// the first run winning ties. Walking the blocks in that order, the fragment left over
+    /// from the previous block is merged with the next block whenever they come from
+    /// different runs, or is final otherwise: no element of a later block can be smaller.
+    /// The fragment is kept in \b buffer, so every local merge writes behind its reads.
+    /// The blocks of the first run starting after the short tail cannot take part in this,
+    /// and they are merged with the tail at the end.
+    /// \par References:
+    /// \li M. A. Kronrod. Optimal Ordering Algorithm without Operational Field. Soviet Math.
+    ///     Dokl. 10, 1969.
+    /// \li B.-C. Huang and M. A. Langston. Fast Stable Merging and Sorting in Constant Extra
+    ///     Space. The Computer Journal 35(6), 1992.
+    template <typename T>
+    void block_merge(T* data, long na, long nb, T* buffer, long block, long* tags)
+    {
+        long min_gallop = tim_sort_min_gallop;
+
+        if (std::min(na, nb) <= block) {
+            tim_sort_merge(data, na, nb, buffer, &min_gallop);
+            return;
+        }
+
+        long head = na % block;
+        long nablocks = na / block;
+        long nbblocks = nb / block;
+        long tail = nb % block;
+        long nblocks = nablocks + nbblocks;
+        T* blocks = data + head;
+        T* last = data + na + nb - tail;
+
+        for (long i = 0; i < nblocks; i++) {
+            tags[i] = i;
+        }
+        block_merge_select(blocks, nblocks, block, tags);
+
+        long nmerged = nblocks;
+        if (tail > 0) {
+            while (nmerged > 0 && tags[nmerged-1] < nablocks && *last < blocks[(nmerged-1) * block]) {
+                nmerged--;
+            }
+        }
+
+        T* out = data;
+        long nf = move_forward(data, data + head, buffer) - buffer;
+        bool from_a = true;
+        for (long i = 0; i < nmerged; i++) {
+            T* g = blocks + i * block;
+            T* gend = g + block;
+            bool g_from_a = tags[i] < nablocks;
+
+            if (nf == 0 || g_from_a == from_a) {
+                out = move_forward(buffer, buffer + nf, out);
+                nf = move_forward(g, gend, buffer) - buffer;
+                from_a = g_from_a;
+                continue;
+            }
+
+            long pf = 0;
+            while (pf < nf && g < gend) {
+                if (from_a ? !(*g < buffer[pf]) : buffer[pf] < *g) {
+                    *out++ = ALGORITHM_MOVE(buffer[pf++]);
+                } else {
+                    *out++ = ALGORITHM_MOVE(*g++);
+                }
+            }
+            if (pf == nf) {
+                nf = move_forward(g, gend, buffer) - buffer;
+                from_a = g_from_a;
+            } else if (pf > 0) {
+                // Moving an element onto itself may empty it, as it does std::string.
+                nf = move_forward(buffer + pf, buffer + nf, buffer) - buffer;
+            }
+        }
+
+        // Whatever is left ahead of the tail is sorted and merged with it.
+        move_forward(buffer, buffer + nf, out);
+        if (tail > 0) {
+            tim_sort_merge(out, last - out, tail, buffer, &min_gallop);
+        }
+    }
+
+
+    /// Selection sort of the blocks by (first element, tag), each block moved at most once.
+    /// There are O(sqrt(n)) blocks, so the O(nblocks^2) comparisons stay within O(n).
+    template <typename T>
+    void block_merge_select(T* data, long nblocks, long block, long* tags)
+    {
+        for (long i = 0; i < nblocks; i++) {
+            long min = i;
+            for (long j = i + 1; j < nblocks; j++) {
+                const T& x = data[j * block];
+                const T& y = data[min * block];
+                if (x < y || (!(y < x) && tags[j] < tags[min])) {
+                    min = j;
+                }
+            }
+            if (min != i) {
+                std::swap_ranges(data + i * block, data + (i+1) * block, data + min * block);
+                std::swap(tags[i], tags[min]);
+            }
+        }
+    }
+} // namespace algorithm
+
+#endif // BLOCKMERGESORT_H
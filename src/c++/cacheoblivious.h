@@ -27,7 +27,12 @@
 #define CACHEOBLIVIOUS_H
 
 #include <cassert>
+#include <cmath>
+#include <algorithm>
+#include <vector>
 #include "matrix2d.h"
+#include "mergesort.h"
+#include "move.h"
 
 namespace algorithm
 {
@@ -72,6 +77,21 @@ namespace algorithm
     template <typename T>
     void co_transpose(const Matrix2D<T>& a, Matrix2D<T>& b,
                       long mstart, long mend, long nstart, long nend);
+
+    /// Sort the \b length elements using the Cache-Oblivious Lazy Funnelsort algorithm.
+    /// \param[in,out] data The pointer to the list of elements.
+    /// \param[in] length The number of elements.
+    /// \note The sort is stable.
+    template <typename T>
+    void co_sort(T* data, long length);
+
+    /// Sort the elements from \b istart to \b iend using the Cache-Oblivious Lazy Funnelsort
+    /// algorithm.
+    /// \param[in,out] data The pointer to the list of elements.
+    /// \param[in] istart The index of the first elements to sort.
+    /// \param[in] iend The index of the last elements to sort.
+    template <typename T>
+    void co_sort(T* data, long istart, long iend);
 } // namespace algorithm
 
 
@@ -178,6 +198,272 @@ namespace algorithm
             co_transpose(a, b, mstart, mend, nmid+1, nend);
         }
     }
+
+
+    /// \brief A lazy k-funnel: a binary merge tree over k sorted runs, with a buffer on every
+    ///        edge that is refilled only when it runs empty.<br>
+    ///        The buffer below a node with L leaves holds about co_funnel_alpha * L^2 elements,
+    ///        and the buffers are laid out in van Emde Boas order of their nodes, so that every
+    ///        subtree of the funnel and its buffers sit together in memory whatever their size.
+    template <typename T>
+    class CoFunnel
+    {
+    public:
+        /// \brief Construct a funnel over the sorted runs data[starts[i]..starts[i+1]).
+        CoFunnel(T* data, const std::vector<long>& starts);
+        ~CoFunnel(void);
+
+        /// \brief Merge all the runs into \b dest.
+        void merge(T* dest);
+
+    private:
+        /// \brief The FIFO buffer below a node.
+        typedef struct {
+            T* m_buffer; ///< The elements, a run of the input for a leaf.
+            long m_capacity; ///< The size of the buffer.
+            long m_head; ///< The index of the next element out.
+            long m_tail; ///< The index past the last element in.
+            bool m_exhausted; ///< Have the runs below been drained?
+        } Node;
+
+        CoFunnel(const CoFunnel& rhs);
+        CoFunnel& operator=(const CoFunnel& rhs);
+
+        /// \brief Merge the buffers of the children of node \b v into \b out, up to \b capacity.
+        /// \return The number of elements merged.
+        long merge_children(long v, T* out, long capacity);
+
+        /// \brief List the internal nodes of the subtree of height \b height at \b root in
+        ///        van Emde Boas order.
+        void veb_order(long root, long height, std::vector<long>& order) const;
+
+        long m_nleaves; ///< The number of leaves, a power of two.
+        long m_total; ///< The number of elements of all the runs.
+        std::vector<Node> m_nodes; ///< The nodes, numbered as a binary heap from 1.
+        T* m_buffers; ///< The storage of the buffers of all the internal nodes.
+        long m_size; ///< The number of elements in m_buffers.
+    };
+
+
+    /// The sizes of the funnel buffers are co_funnel_alpha * (leaves below)^2.
+    static const long co_funnel_alpha = 16;
+
+    /// The arrays with at most this number of elements are sorted by Merge Sort.
+    static const long co_sort_threshold = 1024;
+
+
+    template <typename T>
+    static void co_sort(T* data, long length, T* buffer);
+
+
+    template <typename T>
+    void co_sort(T* data, long length)
+    {
+        assert(length > 0);
+
+        co_sort(data, 0, length-1);
+    }
+
+
+    template <typename T>
+    void co_sort(T* data, long istart, long iend)
+    {
+        assert(iend - istart + 1 > 0);
+
+        long length = iend - istart + 1;
+        // The buffer is constructed by moving the data in and back out, which leaves
+        // assignable elements without requiring a default constructor.
+        T* buffer = allocate_uninitialized<T>(length);
+        uninitialized_move(data + istart, data + iend + 1, buffer);
+        move_forward(buffer, buffer + length, data + istart);
+
+        co_sort(data + istart, length, buffer);
+
+        deallocate_uninitialized(buffer, length);
+    }
+
+
+    /// Sort n^(1/3) segments of n^(2/3) elements recursively, then merge them with a lazy
+    /// n^(1/3)-funnel. There are O((n/B) log_M(n/B)) cache misses for any cache of M elements
+    /// in lines of B, without knowing either.
+    /// \par References:
+    /// \li M. Frigo, C. E. Leiserson, H. Prokop, and S. Ramachandran. Cache-oblivious algorithms.
+    ///     In Proceedings of the 40th IEEE Symposium on Foundations of Computer Science, 1999.
+    /// \li G. S. Brodal and R. Fagerberg. Cache Oblivious Distribution Sweeping. ICALP 2002.
+    /// \li G. S. Brodal, R. Fagerberg and K. Vinther. Engineering a Cache-Oblivious Sorting
+    ///     Algorithm. ACM JEA 12, 2007.
+    template <typename T>
+    void co_sort(T* data, long length, T* buffer)
+    {
+        if (length <= co_sort_threshold) {
+            merge_sort(data, length, buffer);
+            return;
+        }
+
+        long k = static_cast<long>(std::ceil(std::pow(static_cast<double>(length), 1.0 / 3.0)));
+        long segment = (length + k - 1) / k;
+        std::vector<long> starts;
+        for (long i = 0; i < length; i += segment) {
+            long n = std::min(segment, length - i);
+            co_sort(data + i, n, buffer + i);
+            starts.push_back(i);
+        }
+        starts.push_back(length);
+
+        CoFunnel<T> funnel(data, starts);
+        funnel.merge(buffer);
+        move_forward(buffer, buffer + length, data);
+    }
+
+
+    template <typename T>
+    CoFunnel<T>::CoFunnel(T* data, const std::vector<long>& starts)
+        : m_nleaves(2), m_total(starts.back() - starts.front()), m_buffers(NULL), m_size(0)
+    {
+        long k = static_cast<long>(starts.size()) - 1;
+        long height = 1;
+        while (m_nleaves < k) {
+            m_nleaves *= 2;
+            height++;
+        }
+
+        Node empty = { NULL, 0, 0, 0, true };
+        m_nodes.assign(2 * m_nleaves, empty);
+        for (long i = 0; i < k; i++) {
+            Node& leaf = m_nodes[m_nleaves + i];
+            leaf.m_buffer = data + starts[i];
+            leaf.m_capacity = starts[i+1] - starts[i];
+            leaf.m_tail = leaf.m_capacity;
+            leaf.m_exhausted = true;
+        }
+
+        // The root writes to the destination directly; the other internal nodes get buffers.
+        std::vector<long> order;
+        veb_order(1, height, order);
+        std::vector<long> offsets(order.size());
+        long size = 0;
+        for (size_t i = 0; i < order.size(); i++) {
+            long v = order[i];
+            long leaves = m_nleaves;
+            for (long u = v; u > 1; u /= 2) {
+                leaves /= 2;
+            }
+            Node& node = m_nodes[v];
+            node.m_capacity = (v == 1) ? 0 : std::min(co_funnel_alpha * leaves * leaves, m_total);
+            node.m_exhausted = false;
+            offsets[i] = size;
+            size += node.m_capacity;
+        }
+        // The buffers are constructed by moving the runs in and back out, as many times as
+        // needed to cover them, so they need no default constructor.
+        if (size > 0) {
+            T* runs = data + starts.front();
+            m_buffers = allocate_uninitialized<T>(size);
+            for (long i = 0; i < size; i += m_total) {
+                long n = std::min(m_total, size - i);
+                uninitialized_move(runs, runs + n, m_buffers + i);
+                move_forward(m_buffers + i, m_buffers + i + n, runs);
+            }
+        }
+        m_size = size;
+        for (size_t i = 0; i < order.size(); i++) {
+            m_nodes[order[i]].m_buffer = m_buffers + offsets[i];
+        }
+    }
+
+
+    template <typename T>
+    CoFunnel<T>::~CoFunnel(void)
+    {
+        if (m_buffers != NULL) {
+            deallocate_uninitialized(m_buffers, m_size);
+        }
+    }
+
+
+    template <typename T>
+    void CoFunnel<T>::merge(T* dest)
+    {
+        long n = merge_children(1, dest, m_total);
+        assert(n == m_total);
+        (void) n;
+    }
+
+
+    /// Whenever the buffer of a child runs empty before its runs are drained, the child is
+    /// refilled completely by merging its own children, recursively.
+    template <typename T>
+    long CoFunnel<T>::merge_children(long v, T* out, long capacity)
+    {
+        Node& a = m_nodes[2*v];
+        Node& b = m_nodes[2*v + 1];
+        long n = 0;
+
+        while (n < capacity) {
+            if (a.m_head == a.m_tail && !a.m_exhausted) {
+                a.m_head = 0;
+                a.m_tail = merge_children(2*v, a.m_buffer, a.m_capacity);
+            }
+            if (b.m_head == b.m_tail && !b.m_exhausted) {
+                b.m_head = 0;
+                b.m_tail = merge_children(2*v + 1, b.m_buffer, b.m_capacity);
+            }
+
+            T* pa = a.m_buffer + a.m_head;
+            T* ea = a.m_buffer + a.m_tail;
+            T* pb = b.m_buffer + b.m_head;
+            T* eb = b.m_buffer + b.m_tail;
+            if (pa == ea && pb == eb) {
+                m_nodes[v].m_exhausted = true;
+                break;
+            }
+
+            if (pa == ea) {
+                long m = std::min(static_cast<long>(eb - pb), capacity - n);
+                move_forward(pb, pb + m, out + n);
+                pb += m;
+                n += m;
+            } else if (pb == eb) {
+                long m = std::min(static_cast<long>(ea - pa), capacity - n);
+                move_forward(pa, pa + m, out + n);
+                pa += m;
+                n += m;
+            } else {
+                while (pa < ea && pb < eb && n < capacity) {
+                    if (*pb < *pa) {
+                        out[n++] = ALGORITHM_MOVE(*pb++);
+                    } else {
+                        out[n++] = ALGORITHM_MOVE(*pa++);
+                    }
+                }
+            }
+            a.m_head = pa - a.m_buffer;
+            b.m_head = pb - b.m_buffer;
+        }
+        return n;
+    }
+
+
+    /// Cut the tree at half its height, list the top tree, then every bottom tree from left
+    /// to right, each in the same order recursively.
+    template <typename T>
+    void CoFunnel<T>::veb_order(long root, long height, std::vector<long>& order) const
+    {
+        if (root >= m_nleaves) {
+            return;
+        }
+        if (height == 1) {
+            order.push_back(root);
+            return;
+        }
+
+        long bottom = height / 2;
+        long top = height - bottom;
+        veb_order(root, top, order);
+        for (long j = 0; j < (1L << top); j++) {
+            veb_order((root << top) + j, bottom, order);
+        }
+    }
 } // namespace algorithm
 
 #endif // CACHEOBLIVIOUS_H
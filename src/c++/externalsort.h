@@ -0,0 +1,689 @@
+/*
+# Copyright (c) 2008 Chung Shin Yee <cshinyee@gmail.com>
+#
+#       http://github.com/xman
+#       http://myxman.org
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License as
+# published by the Free Software Foundation; either version 2 of the
+# License, or (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+# USA.
+#
+# The GNU General Public License is contained in the file COPYING.
+#
+*/
+
+// External merge sort of files of fixed-size records.
+
+#ifndef EXTERNALSORT_H
+#define EXTERNALSORT_H
+
+#include <cassert>
+#include <algorithm>
+#include <deque>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "losertree.h"
+#include "mergesort.h"
+
+namespace algorithm
+{
+    /// \brief The I/O volume of one pass of external_sort().
+    typedef struct {
+        long nruns; ///< The number of sorted runs written by the pass.
+        long bytes_read; ///< The number of bytes read by the pass.
+        long bytes_written; ///< The number of bytes written by the pass.
+    } ExternalSortPass;
+
+    /// \brief Sort a file of fixed-size records using the External Merge Sort algorithm.<br>
+    ///        Sorted runs are formed in memory with merge_sort() and written to temporary files,
+    ///        then merged k at a time with a tournament tree until one run is left.
+    /// \param T The data type of the records, copied byte for byte to and from the files.
+    /// \param[in] input The path of the file to sort.
+    /// \param[in] output The path of the sorted file to write.
+    /// \param[in] memory The memory budget in bytes.
+    /// \param[in] temp_dir The directory of the temporary run files.
+    /// \param[out] passes The I/O volume of every pass if not NULL, run formation first.
+    /// \return true if the output is written, false on an I/O error or if \b output names
+    ///         the same file as \b input, which cannot be sorted in place.
+    /// \note The sort is stable.
+    template <typename T>
+    bool external_sort(const char* input, const char* output, long memory,
+                       const char* temp_dir, std::vector<ExternalSortPass>* passes = NULL);
+} // namespace algorithm
+
+
+// ===================================================================
+// Implementation
+// ===================================================================
+
+namespace algorithm
+{
+    /// The smallest block read or written at once during the merge passes, in bytes.
+    static const long external_sort_min_block_bytes = 64L << 10;
+
+    /// The largest block read or written at once during the merge passes, in bytes.
+    static const long external_sort_max_block_bytes = 1L << 20;
+
+
+    /// \brief A thread doing blocking reads and writes in submission order, so the caller
+    ///        can compute while its buffers are filled or drained.
+    class ExternalSortIO
+    {
+    public:
+        /// \brief The data type of a read or write request.
+        typedef struct {
+            int fd; ///< The file descriptor.
+            char* buffer; ///< The memory to read into or write from.
+            long bytes; ///< The number of bytes.
+            long offset; ///< The position in the file.
+            bool write; ///< Is it a write?
+            bool done; ///< Has the request completed?
+            bool ok; ///< Did the request succeed?
+        } Request;
+
+        ExternalSortIO(void);
+        ~ExternalSortIO(void);
+
+        /// \brief Queue \b r, which must stay alive until wait() returns.
+        void submit(Request* r, int fd, void* buffer, long bytes, long offset, bool write);
+
+        /// \brief Wait for \b r to complete.
+        /// \return true if all its bytes were transferred.
+        bool wait(Request* r);
+
+    private:
+        ExternalSortIO(const ExternalSortIO& rhs);
+        ExternalSortIO& operator=(const ExternalSortIO& rhs);
+
+        static void* io_main(void* arg);
+
+        pthread_t m_thread; ///< The I/O thread.
+        pthread_mutex_t m_lock; ///< Guards m_queue, m_shutdown and Request::done.
+        pthread_cond_t m_cond; ///< Signalled on submission, completion and shutdown.
+        std::deque<Request*> m_queue; ///< The pending requests.
+        bool m_shutdown; ///< Should the I/O thread exit?
+    };
+
+
+    /// \brief Read a run of records through two alternating buffers.
+    template <typename T>
+    class ExternalRunReader
+    {
+    public:
+        ExternalRunReader(ExternalSortIO* io, int fd, long start, long nrecords, long block,
+                          T* buffers, long* bytes_read);
+        ~ExternalRunReader(void);
+
+        /// \brief Read the first block and start prefetching the second.
+        bool start(void);
+
+        bool empty(void) const;
+        const T& head(void) const;
+
+        /// \brief Move to the next record, switching to the prefetched block at the end of a block.
+        bool advance(void);
+
+        /// \brief Wait for the read in flight, if any, so the buffers can be released.
+        void finish(void);
+
+    private:
+        void prefetch(void);
+
+        /// \brief Wait for the prefetched block and make it current. The run ends on a failed read.
+        bool receive(void);
+
+        ExternalSortIO* m_io;
+        int m_fd;
+        long m_start; ///< The index of the first record of the run in the file.
+        long m_nrecords; ///< The number of records in the run.
+        long m_block; ///< The number of records in a block.
+        T* m_current; ///< The block being consumed.
+        T* m_next; ///< The block being prefetched.
+        long m_pos; ///< The index of the head in m_current.
+        long m_length; ///< The number of records in m_current.
+        long m_issued; ///< The number of records requested so far.
+        long m_next_length; ///< The number of records requested into m_next.
+        bool m_pending; ///< Is a read into m_next in flight?
+        typename ExternalSortIO::Request m_request;
+        long* m_bytes_read;
+    };
+
+
+    /// \brief Write a run of records through two alternating buffers.
+    template <typename T>
+    class ExternalRunWriter
+    {
+    public:
+        ExternalRunWriter(ExternalSortIO* io, int fd, long start, long block, T* buffers, long* bytes_written);
+
+        void put(const T& x);
+
+        /// \brief Write the last partial block and wait for all writes.
+        /// \return true if every write succeeded.
+        bool finish(void);
+
+    private:
+        void flush(void);
+
+        /// \brief Wait for the write in flight, counting its bytes if it succeeded.
+        void wait(void);
+
+        ExternalSortIO* m_io;
+        int m_fd;
+        long m_block;
+        T* m_current; ///< The block being filled.
+        T* m_other; ///< The block being written.
+        long m_length; ///< The number of records in m_current.
+        long m_offset; ///< The file position of the next write.
+        bool m_pending; ///< Is a write of m_other in flight?
+        long m_pending_bytes; ///< The number of bytes of the write in flight.
+        bool m_ok;
+        typename ExternalSortIO::Request m_request;
+        long* m_bytes_written;
+    };
+
+
+    template <typename T>
+    static bool external_sort_runs(ExternalSortIO& io, int in, int out, long nrecords, long run_records,
+                                   std::vector<long>& run_starts, ExternalSortPass& pass);
+
+    template <typename T>
+    static bool external_sort_merge(ExternalSortIO& io, int in, const std::vector<long>& run_starts,
+                                    long first, long k, int out, long block, T* buffers,
+                                    ExternalSortPass& pass);
+
+    static int external_sort_temp_file(const char* temp_dir);
+
+
+    /// \par References:
+    /// The Art of Computer Programming Volume 3: Sorting and Searching, Section 5.4 - Donald E. Knuth
+    template <typename T>
+    bool external_sort(const char* input, const char* output, long memory,
+                       const char* temp_dir, std::vector<ExternalSortPass>* passes)
+    {
+        const long size = sizeof(T);
+
+        assert(memory >= 8 * size);
+
+        int in = open(input, O_RDONLY);
+        if (in < 0) {
+            return false;
+        }
+        struct stat st;
+        if (fstat(in, &st) != 0 || st.st_size % size != 0) {
+            close(in);
+            return false;
+        }
+        long nrecords = st.st_size / size;
+
+        // Truncating the output would destroy the input before it is read.
+        struct stat ost;
+        if (stat(output, &ost) == 0 && ost.st_dev == st.st_dev && ost.st_ino == st.st_ino) {
+            close(in);
+            return false;
+        }
+
+        int out = open(output, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (out < 0) {
+            close(in);
+            return false;
+        }
+
+        ExternalSortIO io;
+        bool ok = true;
+
+        // Pass 0: sorted runs of a third of the memory each, the rest being the
+        // read-ahead and merge buffers. All the runs of a pass share one temporary file.
+        long run_records = std::max(1L, memory / (3 * size));
+        bool single = (nrecords <= run_records);
+        int runs = single ? out : external_sort_temp_file(temp_dir);
+        std::vector<long> starts(1, 0);
+        ExternalSortPass pass = { 0, 0, 0 };
+        if (runs < 0) {
+            ok = false;
+        } else if (nrecords > 0) {
+            ok = external_sort_runs<T>(io, in, runs, nrecords, run_records, starts, pass);
+        }
+        close(in);
+        if (passes != NULL) {
+            passes->push_back(pass);
+        }
+
+        // Merge passes: two blocks per input run and two for the output. The blocks are as
+        // large as allows merging all runs at once, within [64 KB, 1 MB].
+        long nruns = starts.size() - 1;
+        long block_bytes = memory / (2 * (nruns + 1));
+        block_bytes = std::max(block_bytes, external_sort_min_block_bytes);
+        block_bytes = std::min(block_bytes, external_sort_max_block_bytes);
+        block_bytes = std::min(block_bytes, memory / 8);
+        long block = std::max(1L, block_bytes / size);
+        long fanin = std::max(2L, memory / (2 * block * size) - 1);
+        T* buffers = single ? NULL : new T[2 * (fanin + 1) * block];
+
+        while (ok && !single) {
+            bool last = (nruns <= fanin);
+            int merged = last ? out : external_sort_temp_file(temp_dir);
+            std::vector<long> merged_starts(1, 0);
+            ExternalSortPass merge_pass = { 0, 0, 0 };
+            if (merged < 0) {
+                ok = false;
+                break;
+            }
+
+            for (long first = 0; ok && first < nruns; first += fanin) {
+                long k = std::min(fanin, nruns - first);
+                ok = external_sort_merge<T>(io, runs, starts, first, k, merged, block, buffers, merge_pass);
+                merged_starts.push_back(starts[first + k]);
+                merge_pass.nruns++;
+            }
+
+            close(runs);
+            runs = merged;
+            starts = merged_starts;
+            nruns = starts.size() - 1;
+            if (passes != NULL) {
+                passes->push_back(merge_pass);
+            }
+            single = last;
+        }
+        if (runs >= 0 && runs != out) {
+            close(runs);
+        }
+
+        delete[] buffers;
+        if (close(out) != 0) {
+            ok = false;
+        }
+        return ok;
+    }
+
+
+    /// Read the next chunk while the current one is sorted and the previous one written.
+    template <typename T>
+    bool external_sort_runs(ExternalSortIO& io, int in, int out, long nrecords, long run_records,
+                            std::vector<long>& run_starts, ExternalSortPass& pass)
+    {
+        const long size = sizeof(T);
+
+        T* area = new T[3 * run_records];
+        assert(area != NULL);
+        T* current = area;
+        T* next = area + run_records;
+        T* scratch = area + 2 * run_records;
+
+        ExternalSortIO::Request read_request;
+        ExternalSortIO::Request write_request;
+        bool writing = false;
+        long written = 0;
+        bool ok = true;
+
+        long length = std::min(run_records, nrecords);
+        io.submit(&read_request, in, current, length * size, 0, false);
+        for (long offset = 0; offset < nrecords; ) {
+            // Nothing is read ahead of a failed read: stop with the writes drained.
+            if (!io.wait(&read_request)) {
+                ok = false;
+                break;
+            }
+            pass.bytes_read += length * size;
+
+            long next_offset = offset + length;
+            long next_length = std::min(run_records, nrecords - next_offset);
+            if (next_length > 0) {
+                io.submit(&read_request, in, next, next_length * size, next_offset * size, false);
+            }
+
+            merge_sort(current, length, scratch);
+
+            if (writing && io.wait(&write_request)) {
+                pass.bytes_written += written;
+            } else if (writing) {
+                ok = false;
+            }
+            io.submit(&write_request, out, current, length * size, offset * size, true);
+            writing = true;
+            written = length * size;
+            run_starts.push_back(next_offset);
+            pass.nruns++;
+
+            std::swap(current, next);
+            offset = next_offset;
+            length = next_length;
+        }
+        if (writing && io.wait(&write_request)) {
+            pass.bytes_written += written;
+        } else if (writing) {
+            ok = false;
+        }
+
+        delete[] area;
+        return ok;
+    }
+
+
+    /// Merge the runs \b first .. \b first + \b k - 1 of \b in to the same place in \b out.
+    template <typename T>
+    bool external_sort_merge(ExternalSortIO& io, int in, const std::vector<long>& run_starts,
+                             long first, long k, int out, long block, T* buffers,
+                             ExternalSortPass& pass)
+    {
+        bool ok = true;
+
+        std::vector<ExternalRunReader<T>*> readers(k);
+        LoserTree<T> tree(k);
+        for (long i = 0; i < k; i++) {
+            long start = run_starts[first + i];
+            long length = run_starts[first + i + 1] - start;
+            readers[i] = new ExternalRunReader<T>(&io, in, start, length, block,
+                                                   buffers + 2 * i * block, &pass.bytes_read);
+            ok = readers[i]->start() && ok;
+            if (!readers[i]->empty()) {
+                tree.set(i, readers[i]->head());
+            }
+        }
+        tree.build();
+
+        ExternalRunWriter<T> writer(&io, out, run_starts[first], block,
+                                    buffers + 2 * k * block, &pass.bytes_written);
+        while (ok && !tree.empty()) {
+            long w = tree.winner();
+            writer.put(tree.top());
+            ok = readers[w]->advance();
+            if (readers[w]->empty()) {
+                tree.pop();
+            } else {
+                tree.replace_top(readers[w]->head());
+            }
+        }
+        ok = writer.finish() && ok;
+
+        // The buffers are reused by the next merge: no read may still be in flight.
+        for (long i = 0; i < k; i++) {
+            readers[i]->finish();
+            delete readers[i];
+        }
+        return ok;
+    }
+
+
+    /// Create an anonymous file in \b temp_dir, removed when its descriptor is closed.
+    inline int external_sort_temp_file(const char* temp_dir)
+    {
+        std::string path = std::string(temp_dir) + "/algorithm-sort-XXXXXX";
+        std::vector<char> name(path.begin(), path.end());
+        name.push_back('\0');
+
+        int fd = mkstemp(&name[0]);
+        if (fd >= 0) {
+            unlink(&name[0]);
+        }
+        return fd;
+    }
+
+
+    inline ExternalSortIO::ExternalSortIO(void) : m_queue(), m_shutdown(false)
+    {
+        pthread_mutex_init(&m_lock, NULL);
+        pthread_cond_init(&m_cond, NULL);
+        int rc = pthread_create(&m_thread, NULL, io_main, this);
+        assert(rc == 0);
+        (void)rc;
+    }
+
+
+    inline ExternalSortIO::~ExternalSortIO(void)
+    {
+        pthread_mutex_lock(&m_lock);
+        m_shutdown = true;
+        pthread_cond_broadcast(&m_cond);
+        pthread_mutex_unlock(&m_lock);
+
+        pthread_join(m_thread, NULL);
+        pthread_cond_destroy(&m_cond);
+        pthread_mutex_destroy(&m_lock);
+    }
+
+
+    inline void ExternalSortIO::submit(Request* r, int fd, void* buffer, long bytes, long offset, bool write)
+    {
+        r->fd = fd;
+        r->buffer = static_cast<char*>(buffer);
+        r->bytes = bytes;
+        r->offset = offset;
+        r->write = write;
+        r->done = false;
+        r->ok = false;
+
+        pthread_mutex_lock(&m_lock);
+        m_queue.push_back(r);
+        pthread_cond_broadcast(&m_cond);
+        pthread_mutex_unlock(&m_lock);
+    }
+
+
+    inline bool ExternalSortIO::wait(Request* r)
+    {
+        pthread_mutex_lock(&m_lock);
+        while (!r->done) {
+            pthread_cond_wait(&m_cond, &m_lock);
+        }
+        pthread_mutex_unlock(&m_lock);
+        return r->ok;
+    }
+
+
+    inline void* ExternalSortIO::io_main(void* arg)
+    {
+        ExternalSortIO* io = static_cast<ExternalSortIO*>(arg);
+
+        for (;;) {
+            pthread_mutex_lock(&io->m_lock);
+            while (io->m_queue.empty() && !io->m_shutdown) {
+                pthread_cond_wait(&io->m_cond, &io->m_lock);
+            }
+            if (io->m_queue.empty()) {
+                pthread_mutex_unlock(&io->m_lock);
+                break;
+            }
+            Request* r = io->m_queue.front();
+            io->m_queue.pop_front();
+            pthread_mutex_unlock(&io->m_lock);
+
+            long done = 0;
+            while (done < r->bytes) {
+                ssize_t n = r->write ? pwrite(r->fd, r->buffer + done, r->bytes - done, r->offset + done)
+                                     : pread(r->fd, r->buffer + done, r->bytes - done, r->offset + done);
+                if (n <= 0) {
+                    break;
+                }
+                done += n;
+            }
+
+            pthread_mutex_lock(&io->m_lock);
+            r->ok = (done == r->bytes);
+            r->done = true;
+            pthread_cond_broadcast(&io->m_cond);
+            pthread_mutex_unlock(&io->m_lock);
+        }
+        return NULL;
+    }
+
+
+    template <typename T>
+    ExternalRunReader<T>::ExternalRunReader(ExternalSortIO* io, int fd, long start, long nrecords,
+                                            long block, T* buffers, long* bytes_read) :
+        m_io(io), m_fd(fd), m_start(start), m_nrecords(nrecords), m_block(block),
+        m_current(buffers), m_next(buffers + block), m_pos(0), m_length(0),
+        m_issued(0), m_next_length(0), m_pending(false), m_request(), m_bytes_read(bytes_read)
+    {
+    }
+
+
+    template <typename T>
+    ExternalRunReader<T>::~ExternalRunReader(void)
+    {
+        finish();
+    }
+
+
+    template <typename T>
+    bool ExternalRunReader<T>::start(void)
+    {
+        prefetch();
+        if (m_next_length == 0) {
+            return true;
+        }
+        return receive();
+    }
+
+
+    template <typename T>
+    inline bool ExternalRunReader<T>::empty(void) const
+    {
+        return m_pos >= m_length;
+    }
+
+
+    template <typename T>
+    inline const T& ExternalRunReader<T>::head(void) const
+    {
+        return m_current[m_pos];
+    }
+
+
+    template <typename T>
+    inline bool ExternalRunReader<T>::advance(void)
+    {
+        if (++m_pos < m_length || m_next_length == 0) {
+            return true;
+        }
+        return receive();
+    }
+
+
+    template <typename T>
+    void ExternalRunReader<T>::finish(void)
+    {
+        if (m_pending) {
+            m_io->wait(&m_request);
+            m_pending = false;
+        }
+    }
+
+
+    template <typename T>
+    bool ExternalRunReader<T>::receive(void)
+    {
+        const long size = sizeof(T);
+
+        bool ok = m_io->wait(&m_request);
+        m_pending = false;
+        if (!ok) {
+            m_length = 0;
+            m_next_length = 0;
+            m_pos = 0;
+            return false;
+        }
+        *m_bytes_read += m_next_length * size;
+
+        std::swap(m_current, m_next);
+        m_length = m_next_length;
+        m_pos = 0;
+        prefetch();
+        return true;
+    }
+
+
+    template <typename T>
+    void ExternalRunReader<T>::prefetch(void)
+    {
+        const long size = sizeof(T);
+
+        m_next_length = std::min(m_block, m_nrecords - m_issued);
+        if (m_next_length > 0) {
+            m_io->submit(&m_request, m_fd, m_next, m_next_length * size, (m_start + m_issued) * size, false);
+            m_issued += m_next_length;
+            m_pending = true;
+        }
+    }
+
+
+    template <typename T>
+    ExternalRunWriter<T>::ExternalRunWriter(ExternalSortIO* io, int fd, long start, long block,
+                                            T* buffers, long* bytes_written) :
+        m_io(io), m_fd(fd), m_block(block), m_current(buffers), m_other(buffers + block),
+        m_length(0), m_offset(start * sizeof(T)), m_pending(false),
+        m_pending_bytes(0), m_ok(true), m_request(), m_bytes_written(bytes_written)
+    {
+    }
+
+
+    template <typename T>
+    inline void ExternalRunWriter<T>::put(const T& x)
+    {
+        m_current[m_length++] = x;
+        if (m_length == m_block) {
+            flush();
+        }
+    }
+
+
+    template <typename T>
+    bool ExternalRunWriter<T>::finish(void)
+    {
+        if (m_length > 0) {
+            flush();
+        }
+        if (m_pending) {
+            wait();
+        }
+        return m_ok;
+    }
+
+
+    template <typename T>
+    void ExternalRunWriter<T>::flush(void)
+    {
+        const long size = sizeof(T);
+
+        if (m_pending) {
+            wait();
+        }
+        m_io->submit(&m_request, m_fd, m_current, m_length * size, m_offset, true);
+        m_pending = true;
+        m_pending_bytes = m_length * size;
+        m_offset += m_length * size;
+        std::swap(m_current, m_other);
+        m_length = 0;
+    }
+
+
+    template <typename T>
+    void ExternalRunWriter<T>::wait(void)
+    {
+        if (m_io->wait(&m_request)) {
+            *m_bytes_written += m_pending_bytes;
+        } else {
+            m_ok = false;
+        }
+        m_pending = false;
+    }
+} // namespace algorithm
+
+#endif // EXTERNALSORT_H
@@ -0,0 +1,399 @@
+/*
+# Copyright (c) 2008 Chung Shin Yee <cshinyee@gmail.com>
+#
+#       http://github.com/xman
+#       http://myxman.org
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License as
+# published by the Free Software Foundation; either version 2 of the
+# License, or (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+# USA.
+#
+# The GNU General Public License is contained in the file COPYING.
+#
+*/
+
+// A work-stealing fork-join thread pool on POSIX threads.
+
+#ifndef FORKJOIN_H
+#define FORKJOIN_H
+
+#include <cassert>
+#include <deque>
+#include <vector>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+namespace algorithm
+{
+    class ForkJoinPool;
+
+    /// \brief A unit of work executed by a ForkJoinPool.
+    class ForkJoinTask
+    {
+    public:
+        ForkJoinTask(void);
+        virtual ~ForkJoinTask(void);
+
+        /// \brief Perform the work of this task.
+        /// \param[in] pool The pool executing this task, used to fork and join subtasks.
+        /// \note Every subtask forked by compute() must be joined before compute() returns.
+        virtual void compute(ForkJoinPool& pool) = 0;
+
+        /// \brief Has the task finished?
+        /// \return true if compute() has returned, false otherwise.
+        bool done(void) const;
+
+    private:
+        friend class ForkJoinPool;
+        volatile int m_done; ///< Non-zero once compute() has returned.
+    };
+
+
+    /// \brief A fixed set of worker threads, each with its own task deque.<br>
+    ///        A worker pops its newest task first and steals the oldest task of another
+    ///        worker when its own deque is empty.
+    class ForkJoinPool
+    {
+    public:
+        /// \brief Start a pool of \b nthreads workers.
+        /// \param[in] nthreads The number of workers including the thread calling invoke(),
+        ///            or 0 for the number of online processors.
+        explicit ForkJoinPool(long nthreads = 0);
+        ~ForkJoinPool(void);
+
+        /// \brief Get the number of workers.
+        /// \return The number of workers including the thread calling invoke().
+        long nthreads(void) const;
+
+        /// \brief Run \b task on the pool and wait until it and all its subtasks have finished.
+        /// \param[in,out] task The root task.
+        /// \note The calling thread takes part as worker 0. Only one thread may call invoke() at a time.
+        void invoke(ForkJoinTask& task);
+
+        /// \brief Make \b task available to run asynchronously.
+        /// \param[in,out] task The subtask, which must stay alive until joined.
+        /// \warning It's an error to call fork() outside ForkJoinTask::compute().
+        void fork(ForkJoinTask& task);
+
+        /// \brief Wait for \b task to finish, running other pending tasks meanwhile.
+        /// \param[in,out] task A subtask previously passed to fork().
+        void join(ForkJoinTask& task);
+
+    private:
+        ForkJoinPool(const ForkJoinPool& rhs);
+        ForkJoinPool& operator=(const ForkJoinPool& rhs);
+
+        /// \brief The data type of a per-worker task deque.
+        typedef struct {
+            pthread_mutex_t lock; ///< Guards tasks.
+            std::deque<ForkJoinTask*> tasks; ///< Pushed and popped at the back, stolen from the front.
+            long size; ///< The number of tasks, read without the lock as a hint.
+        } Worker;
+
+        /// \brief The startup argument of a worker thread.
+        typedef struct {
+            ForkJoinPool* pool; ///< The pool owning the worker.
+            long id; ///< The index of the worker.
+        } WorkerArg;
+
+        static void* worker_main(void* arg);
+
+        /// \brief Get the index of the worker running on the calling thread.
+        /// \return The worker index, or -1 if the calling thread is not a worker.
+        long current_worker(void) const;
+
+        /// \brief Take a task from the worker \b id, or steal one from another worker.
+        /// \param[in] id The index of the worker looking for work.
+        /// \return The task taken, NULL if every deque is empty.
+        ForkJoinTask* take(long id);
+
+        /// \brief Run \b task and mark it done.
+        void execute(ForkJoinTask* task);
+
+        /// \brief Wait for a task to be forked while an invoke() is in progress.
+        /// \return false if the pool is shutting down.
+        bool idle(void);
+
+        /// \brief Wake a sleeping worker if tasks are pending and no idle worker is polling.
+        void wake(void);
+
+        long m_nthreads; ///< The number of workers.
+        std::vector<Worker> m_workers; ///< The task deques, one per worker.
+        std::vector<WorkerArg> m_args; ///< The startup arguments of workers 1 .. m_nthreads-1.
+        std::vector<pthread_t> m_threads; ///< The threads of workers 1 .. m_nthreads-1.
+        pthread_key_t m_worker_key; ///< The worker index plus one of the calling thread.
+        pthread_mutex_t m_state_lock; ///< Guards m_running and m_shutdown.
+        pthread_cond_t m_state_cond; ///< Signalled when m_running or m_shutdown changes, or a task is forked.
+        bool m_running; ///< Is an invoke() in progress?
+        bool m_shutdown; ///< Should the workers exit?
+        volatile long m_pending; ///< The number of tasks in all the deques.
+        volatile long m_sleeping; ///< The number of workers waiting on m_state_cond.
+        volatile long m_spinning; ///< The number of idle workers polling m_pending.
+    };
+} // namespace algorithm
+
+
+// ===================================================================
+// Implementation
+// ===================================================================
+
+namespace algorithm
+{
+    /// An idle worker polls the pending task count this number of times before sleeping.
+    static const long fork_join_idle_spins = 64;
+
+
+    inline ForkJoinTask::ForkJoinTask(void) : m_done(0)
+    {
+    }
+
+
+    inline ForkJoinTask::~ForkJoinTask(void)
+    {
+    }
+
+
+    inline bool ForkJoinTask::done(void) const
+    {
+        return __sync_fetch_and_add(const_cast<volatile int*>(&m_done), 0) != 0;
+    }
+
+
+    inline ForkJoinPool::ForkJoinPool(long nthreads) :
+        m_nthreads(nthreads), m_workers(), m_args(), m_threads(),
+        m_running(false), m_shutdown(false), m_pending(0), m_sleeping(0), m_spinning(0)
+    {
+        if (m_nthreads <= 0) {
+            m_nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+        }
+        if (m_nthreads <= 0) {
+            m_nthreads = 1;
+        }
+
+        m_workers.resize(m_nthreads);
+        for (long i = 0; i < m_nthreads; i++) {
+            pthread_mutex_init(&m_workers[i].lock, NULL);
+            m_workers[i].size = 0;
+        }
+        pthread_key_create(&m_worker_key, NULL);
+        pthread_mutex_init(&m_state_lock, NULL);
+        pthread_cond_init(&m_state_cond, NULL);
+
+        m_args.resize(m_nthreads);
+        m_threads.resize(m_nthreads);
+        for (long i = 1; i < m_nthreads; i++) {
+            m_args[i].pool = this;
+            m_args[i].id = i;
+            int rc = pthread_create(&m_threads[i], NULL, worker_main, &m_args[i]);
+            assert(rc == 0);
+            (void)rc;
+        }
+    }
+
+
+    inline ForkJoinPool::~ForkJoinPool(void)
+    {
+        pthread_mutex_lock(&m_state_lock);
+        m_shutdown = true;
+        pthread_cond_broadcast(&m_state_cond);
+        pthread_mutex_unlock(&m_state_lock);
+
+        for (long i = 1; i < m_nthreads; i++) {
+            pthread_join(m_threads[i], NULL);
+        }
+
+        pthread_cond_destroy(&m_state_cond);
+        pthread_mutex_destroy(&m_state_lock);
+        pthread_key_delete(m_worker_key);
+        for (long i = 0; i < m_nthreads; i++) {
+            pthread_mutex_destroy(&m_workers[i].lock);
+        }
+    }
+
+
+    inline long ForkJoinPool::nthreads(void) const
+    {
+        return m_nthreads;
+    }
+
+
+    inline void ForkJoinPool::invoke(ForkJoinTask& task)
+    {
+        assert(current_worker() == -1);
+
+        pthread_setspecific(m_worker_key, reinterpret_cast<void*>(1));
+
+        pthread_mutex_lock(&m_state_lock);
+        m_running = true;
+        pthread_cond_broadcast(&m_state_cond);
+        pthread_mutex_unlock(&m_state_lock);
+
+        execute(&task);
+
+        pthread_mutex_lock(&m_state_lock);
+        m_running = false;
+        pthread_mutex_unlock(&m_state_lock);
+
+        pthread_setspecific(m_worker_key, NULL);
+    }
+
+
+    inline void ForkJoinPool::fork(ForkJoinTask& task)
+    {
+        long id = current_worker();
+        assert(id >= 0);
+
+        Worker& w = m_workers[id];
+        pthread_mutex_lock(&w.lock);
+        w.tasks.push_back(&task);
+        __atomic_store_n(&w.size, static_cast<long>(w.tasks.size()), __ATOMIC_RELAXED);
+        pthread_mutex_unlock(&w.lock);
+
+        __sync_fetch_and_add(&m_pending, 1);
+        wake();
+    }
+
+
+    inline void ForkJoinPool::join(ForkJoinTask& task)
+    {
+        long id = current_worker();
+        assert(id >= 0);
+
+        while (!task.done()) {
+            ForkJoinTask* t = take(id);
+            if (t != NULL) {
+                execute(t);
+            } else {
+                sched_yield();
+            }
+        }
+    }
+
+
+    inline void* ForkJoinPool::worker_main(void* arg)
+    {
+        WorkerArg* a = static_cast<WorkerArg*>(arg);
+        ForkJoinPool* pool = a->pool;
+        long id = a->id;
+
+        pthread_setspecific(pool->m_worker_key, reinterpret_cast<void*>(id + 1));
+
+        for (;;) {
+            ForkJoinTask* t = pool->take(id);
+            if (t != NULL) {
+                // More tasks may wait for the worker this one stopped being.
+                pool->wake();
+                pool->execute(t);
+            } else if (!pool->idle()) {
+                break;
+            }
+        }
+        return NULL;
+    }
+
+
+    /// Poll the pending task count a while, which costs no lock, then sleep until a task is
+    /// forked during an invoke(). Idle workers thus keep off the locks of the busy ones.
+    inline bool ForkJoinPool::idle(void)
+    {
+        __sync_fetch_and_add(&m_spinning, 1);
+        for (long i = 0; i < fork_join_idle_spins; i++) {
+            if (__atomic_load_n(&m_pending, __ATOMIC_SEQ_CST) > 0) {
+                __sync_fetch_and_sub(&m_spinning, 1);
+                return true;
+            }
+            sched_yield();
+        }
+        __sync_fetch_and_sub(&m_spinning, 1);
+
+        pthread_mutex_lock(&m_state_lock);
+        __sync_fetch_and_add(&m_sleeping, 1);
+        while (!m_shutdown && (!m_running || __atomic_load_n(&m_pending, __ATOMIC_SEQ_CST) == 0)) {
+            pthread_cond_wait(&m_state_cond, &m_state_lock);
+        }
+        __sync_fetch_and_sub(&m_sleeping, 1);
+        bool shutdown = m_shutdown;
+        pthread_mutex_unlock(&m_state_lock);
+        return !shutdown;
+    }
+
+
+    /// The callers have raised m_pending or left the polling workers, a full barrier, before
+    /// they read the counts, and a worker about to sleep counts itself, then checks m_pending
+    /// under the lock: either it sees the task or the task's owner sees it sleeping.
+    inline void ForkJoinPool::wake(void)
+    {
+        if (__atomic_load_n(&m_sleeping, __ATOMIC_SEQ_CST) > 0 && __atomic_load_n(&m_spinning, __ATOMIC_SEQ_CST) == 0
+            && __atomic_load_n(&m_pending, __ATOMIC_SEQ_CST) > 0) {
+            pthread_mutex_lock(&m_state_lock);
+            pthread_cond_signal(&m_state_cond);
+            pthread_mutex_unlock(&m_state_lock);
+        }
+    }
+
+
+    inline long ForkJoinPool::current_worker(void) const
+    {
+        return reinterpret_cast<long>(pthread_getspecific(m_worker_key)) - 1;
+    }
+
+
+    inline ForkJoinTask* ForkJoinPool::take(long id)
+    {
+        ForkJoinTask* t = NULL;
+
+        // Newest task of our own deque first, for locality.
+        Worker& own = m_workers[id];
+        if (__atomic_load_n(&own.size, __ATOMIC_RELAXED) > 0) {
+            pthread_mutex_lock(&own.lock);
+            if (!own.tasks.empty()) {
+                t = own.tasks.back();
+                own.tasks.pop_back();
+                __atomic_store_n(&own.size, static_cast<long>(own.tasks.size()), __ATOMIC_RELAXED);
+            }
+            pthread_mutex_unlock(&own.lock);
+        }
+
+        // Otherwise steal the oldest, and usually largest, task of another worker. The
+        // deques seen empty without their lock are skipped.
+        for (long k = 1; t == NULL && k < m_nthreads && __atomic_load_n(&m_pending, __ATOMIC_SEQ_CST) > 0; k++) {
+            Worker& victim = m_workers[(id + k) % m_nthreads];
+            if (__atomic_load_n(&victim.size, __ATOMIC_RELAXED) == 0) {
+                continue;
+            }
+            pthread_mutex_lock(&victim.lock);
+            if (!victim.tasks.empty()) {
+                t = victim.tasks.front();
+                victim.tasks.pop_front();
+                __atomic_store_n(&victim.size, static_cast<long>(victim.tasks.size()), __ATOMIC_RELAXED);
+            }
+            pthread_mutex_unlock(&victim.lock);
+        }
+
+        if (t != NULL) {
+            __sync_fetch_and_sub(&m_pending, 1);
+        }
+        return t;
+    }
+
+
+    inline void ForkJoinPool::execute(ForkJoinTask* task)
+    {
+        task->compute(*this);
+        __sync_fetch_and_or(&task->m_done, 1);
+    }
+} // namespace algorithm
+
+#endif // FORKJOIN_H
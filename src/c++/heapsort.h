@@ -0,0 +1,108 @@
+/*
+# Copyright (c) 2008 Chung Shin Yee <cshinyee@gmail.com>
+#
+#       http://github.com/xman
+#       http://myxman.org
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License as
+# published by the Free Software Foundation; either version 2 of the
+# License, or (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+# USA.
+#
+# The GNU General Public License is contained in the file COPYING.
+#
+*/
+
+#ifndef HEAPSORT_H
+#define HEAPSORT_H
+
+#include <cassert>
+#include <algorithm>
+
+namespace algorithm
+{
+    /// \brief Sort the \b length elements using the Heap Sort algorithm.
+    /// \param T The data type of the elements.
+    /// \param[in,out] data The pointer to the list of elements.
+    /// \param[in] length The number of elements.
+    template <typename T>
+    void heap_sort(T* data, long length);
+
+    /// \brief Sort the elements from \b istart to \b iend using the Heap Sort algorithm.
+    /// \param T The data type of the elements.
+    /// \param[in,out] data The pointer to the list of elements.
+    /// \param[in] istart The index of the first elements to sort.
+    /// \param[in] iend The index of the last elements to sort.
+    template <typename T>
+    void heap_sort(T* data, long istart, long iend);
+} // namespace algorithm
+
+
+// ===================================================================
+// Implementation
+// ===================================================================
+
+namespace algorithm
+{
+    template <typename T>
+    static void sift_down(T* data, long root, long length);
+
+
+    /// \par References:
+    /// Introduction to Algorithms - T. H. Cormen, C. E. Leiserson, R. L. Rivest & C. Stein
+    template <typename T>
+    void heap_sort(T* data, long length)
+    {
+        assert(length > 0);
+
+        // Build a max-heap bottom-up.
+        for (long i = length / 2 - 1; i >= 0; i--) {
+            sift_down(data, i, length);
+        }
+
+        // Repeatedly move the maximum to the end of the shrinking heap.
+        for (long n = length - 1; n > 0; n--) {
+            std::swap(data[0], data[n]);
+            sift_down(data, 0L, n);
+        }
+    }
+
+
+    template <typename T>
+    void heap_sort(T* data, long istart, long iend)
+    {
+        assert(iend - istart + 1 > 0);
+
+        heap_sort(data + istart, iend - istart + 1);
+    }
+
+
+    template <typename T>
+    void sift_down(T* data, long root, long length)
+    {
+        long child = 2 * root + 1;
+        while (child < length) {
+            if (child + 1 < length && !(data[child+1] <= data[child])) {
+                child++;
+            }
+            if (data[child] <= data[root]) {
+                break;
+            }
+            std::swap(data[root], data[child]);
+            root = child;
+            child = 2 * root + 1;
+        }
+    }
+} // namespace algorithm
+
+#endif // HEAPSORT_H
@@ -27,6 +27,7 @@
 #define INSERTIONSORT_H
 
 #include <cassert>
+#include "move.h"
 
 namespace algorithm
 {
@@ -54,7 +55,7 @@ namespace algorithm
 namespace algorithm
 {
     template <typename T>
-    static long shift_vacant(T* data, long xindex, T x);
+    static long shift_vacant(T* data, long xindex, const T& x);
 
 
     /// \par References:
@@ -64,10 +65,13 @@ namespace algorithm
     {
         assert(length > 0);
 
-        for (long i = 0; i < length; i++) {
-            T current = data[i];
+        for (long i = 1; i < length; i++) {
+            if (data[i-1] <= data[i]) {
+                continue;
+            }
+            T current = ALGORITHM_MOVE(data[i]);
             long xloc = shift_vacant(data, i, current);
-            data[xloc] = current;
+            data[xloc] = ALGORITHM_MOVE(current);
         }
     }
 
@@ -78,12 +82,13 @@ namespace algorithm
         assert(iend - istart + 1 > 0);
 
         long length = iend - istart + 1;
-        insertion_sort(data, length);
+        insertion_sort(data + istart, length);
     }
 
 
+    /// Elements are moved one slot right, never copied.
     template <typename T>
-    long shift_vacant(T* data, long xindex, T x)
+    long shift_vacant(T* data, long xindex, const T& x)
     {
         long vacant, xloc;
         vacant = xindex;
@@ -93,7 +98,7 @@ namespace algorithm
                 xloc = vacant;
                 break;
             }
-            data[vacant] = data[vacant-1];
+            data[vacant] = ALGORITHM_MOVE(data[vacant-1]);
             vacant--;
         }
         return xloc;
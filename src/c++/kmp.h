@@ -46,6 +46,56 @@ namespace algorithm
     /// \return The index in \b text where a copy of \b pattern begins.
     /// \return -1 if no match for \b pattern is found.
     long kmp_scan(const char* pattern, const char* text, long length, const long* failure_link);
+
+    /// \brief A KMP automaton scanning a stream of bytes for every occurrence of a pattern.<br>
+    ///        The stream is fed in chunks of explicit length, which may contain NUL bytes, and
+    ///        the state of the automaton is carried from one chunk to the next, so occurrences
+    ///        spanning a chunk boundary are found. Occurrences may overlap.
+    class KmpMatcher
+    {
+    public:
+        /// \brief Construct a matcher at the start of a stream.
+        /// \param[in] pattern The pattern string.
+        /// \param[in] length The length of the pattern string.
+        /// \param[in] failure_link The failure links set up by kmp_setup().
+        /// \note \b pattern and \b failure_link are not copied and must outlive the matcher.
+        KmpMatcher(const char* pattern, long length, const long* failure_link);
+        ~KmpMatcher(void);
+
+        /// \brief Go back to the start of a stream.
+        void reset(void);
+
+        /// \brief Get the number of bytes scanned since the start of the stream.
+        long position(void) const;
+
+        /// \brief Scan the next chunk of the stream and report every occurrence ending in it.
+        /// \param F The type of a function or function object called as report(offset).
+        /// \param[in] chunk The bytes of the chunk.
+        /// \param[in] length The number of bytes of the chunk.
+        /// \param[in] report Called with the stream offset where each occurrence begins.
+        /// \return The number of occurrences reported.
+        template <typename F>
+        long scan(const char* chunk, long length, F report);
+
+        /// \brief Scan the next chunk of the stream, storing the stream offsets where the
+        ///        occurrences begin into \b offsets until \b capacity of them are found.
+        /// \param[in] chunk The bytes of the chunk.
+        /// \param[in] length The number of bytes of the chunk.
+        /// \param[out] offsets The stream offsets of the occurrences, in increasing order.
+        /// \param[in] capacity The maximum number of offsets to store.
+        /// \param[out] consumed The number of bytes scanned, less than \b length when the
+        ///             offsets filled up: the rest of the chunk is to be scanned again.
+        /// \return The number of offsets stored.
+        long scan(const char* chunk, long length, long* offsets, long capacity, long* consumed);
+
+    private:
+        const char* m_pattern; ///< The pattern string.
+        long m_length; ///< The length of the pattern string.
+        const long* m_failure_link; ///< The failure links of the pattern string.
+        long m_border; ///< The length of the longest proper border of the whole pattern.
+        long m_state; ///< The number of pattern bytes matched by the end of the stream.
+        long m_position; ///< The number of bytes scanned.
+    };
 } // namespace algorithm
 
 
@@ -55,7 +105,7 @@ namespace algorithm
 
 namespace algorithm
 {
-    void kmp_setup(const char* pattern, long length, long* failure_link)
+    inline void kmp_setup(const char* pattern, long length, long* failure_link)
     {
         assert(length > 0);
 
@@ -75,7 +125,7 @@ namespace algorithm
 
     /// \par References:
     /// Computer Algorithms Introduction to Design and Analysis - Sara Baase & Allen Van Gelder
-    long kmp_scan(const char* pattern, const char* text, long length, const long* failure_link)
+    inline long kmp_scan(const char* pattern, const char* text, long length, const long* failure_link)
     {
         assert(length > 0);
 
@@ -101,6 +151,98 @@ namespace algorithm
         }
         return match;
     }
+
+
+    /// After a full match, the automaton resumes from the longest proper border of the
+    /// pattern, which extends the failure links by one entry.
+    inline KmpMatcher::KmpMatcher(const char* pattern, long length, const long* failure_link) :
+        m_pattern(pattern), m_length(length), m_failure_link(failure_link),
+        m_border(0), m_state(0), m_position(0)
+    {
+        assert(length > 0);
+
+        long s = failure_link[length-1];
+        while (s >= 0 && pattern[s] != pattern[length-1]) {
+            s = failure_link[s];
+        }
+        m_border = s + 1;
+    }
+
+
+    inline KmpMatcher::~KmpMatcher(void)
+    {
+    }
+
+
+    inline void KmpMatcher::reset(void)
+    {
+        m_state = 0;
+        m_position = 0;
+    }
+
+
+    inline long KmpMatcher::position(void) const
+    {
+        return m_position;
+    }
+
+
+    template <typename F>
+    long KmpMatcher::scan(const char* chunk, long length, F report)
+    {
+        assert(length >= 0);
+
+        const char* pattern = m_pattern;
+        const long* failure_link = m_failure_link;
+        long k = m_state;
+        long found = 0;
+
+        for (long j = 0; j < length; j++) {
+            char c = chunk[j];
+            while (k >= 0 && pattern[k] != c) {
+                k = failure_link[k];
+            }
+            k++;
+            if (k == m_length) {
+                report(m_position + j + 1 - m_length);
+                found++;
+                k = m_border;
+            }
+        }
+        m_state = k;
+        m_position += length;
+        return found;
+    }
+
+
+    inline long KmpMatcher::scan(const char* chunk, long length, long* offsets, long capacity,
+                                 long* consumed)
+    {
+        assert(length >= 0);
+        assert(capacity > 0);
+
+        const char* pattern = m_pattern;
+        const long* failure_link = m_failure_link;
+        long k = m_state;
+        long found = 0;
+        long j = 0;
+
+        while (j < length && found < capacity) {
+            char c = chunk[j++];
+            while (k >= 0 && pattern[k] != c) {
+                k = failure_link[k];
+            }
+            k++;
+            if (k == m_length) {
+                offsets[found++] = m_position + j - m_length;
+                k = m_border;
+            }
+        }
+        m_state = k;
+        m_position += j;
+        *consumed = j;
+        return found;
+    }
 } // namespace algorithm
 
 #endif // KMP_H
@@ -0,0 +1,276 @@
+/*
+# Copyright (c) 2008 Chung Shin Yee <cshinyee@gmail.com>
+#
+#       http://github.com/xman
+#       http://myxman.org
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License as
+# published by the Free Software Foundation; either version 2 of the
+# License, or (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+# USA.
+#
+# The GNU General Public License is contained in the file COPYING.
+#
+*/
+
+#ifndef KWAYMERGE_H
+#define KWAYMERGE_H
+
+#include <cassert>
+#include <algorithm>
+#include <vector>
+#include "forkjoin.h"
+#include "losertree.h"
+#include "parallelmergesort.h"
+
+namespace algorithm
+{
+    /// \brief Merge \b k sorted runs with a loser tree.
+    /// \param T The data type of the elements.
+    /// \param[in] runs The sorted runs.
+    /// \param[in] lengths The number of elements in each run.
+    /// \param[in] k The number of runs.
+    /// \param[out] out The output of as many elements as all the runs.
+    /// \note The merge is stable: equal elements come out in the order of their runs.
+    template <typename T>
+    void multiway_merge(const T* const* runs, const long* lengths, long k, T* out);
+
+    /// \brief Merge \b k sorted runs on all online processors.
+    template <typename T>
+    void parallel_multiway_merge(const T* const* runs, const long* lengths, long k, T* out);
+
+    /// \brief Merge \b k sorted runs on the workers of \b pool, each writing a disjoint slice
+    ///        of the output.
+    /// \param T The data type of the elements.
+    /// \param[in,out] pool The thread pool to run on.
+    /// \param[in] runs The sorted runs.
+    /// \param[in] lengths The number of elements in each run.
+    /// \param[in] k The number of runs.
+    /// \param[out] out The output of as many elements as all the runs.
+    /// \note The result is identical to multiway_merge().
+    template <typename T>
+    void parallel_multiway_merge(ForkJoinPool& pool, const T* const* runs, const long* lengths,
+                                 long k, T* out);
+
+    /// \brief Split \b k sorted runs so that the first \b rank elements of their stable merge
+    ///        are the first splits[i] elements of each run i.
+    /// \param T The data type of the elements.
+    /// \param[in] runs The sorted runs.
+    /// \param[in] lengths The number of elements in each run.
+    /// \param[in] k The number of runs.
+    /// \param[in] rank The number of elements before the splits.
+    /// \param[out] splits The \b k split positions, adding up to \b rank.
+    template <typename T>
+    void multisequence_select(const T* const* runs, const long* lengths, long k, long rank, long* splits);
+} // namespace algorithm
+
+
+// ===================================================================
+// Implementation
+// ===================================================================
+
+namespace algorithm
+{
+    /// The slices of at most this number of output elements are merged sequentially.
+    static const long parallel_multiway_merge_cutoff = 1L << 16;
+
+
+    template <typename T>
+    static void multisequence_select(const T* const* runs, long k, long rank, long* lo, long* hi);
+
+
+    /// \brief Merge the runs between two sets of splits into the output slice they delimit,
+    ///        splitting the slice in half by multi-sequence selection until it is small.
+    template <typename T>
+    class MultiwayMergeTask : public ForkJoinTask
+    {
+    public:
+        MultiwayMergeTask(const T* const* runs, long k, const long* begin, const long* end,
+                          long rank, long length, T* out) :
+            m_runs(runs), m_k(k), m_begin(begin), m_end(end), m_rank(rank), m_length(length), m_out(out)
+        {
+        }
+
+        void compute(ForkJoinPool& pool)
+        {
+            if (m_length <= parallel_multiway_merge_cutoff) {
+                std::vector<const T*> runs(m_k);
+                std::vector<long> lengths(m_k);
+                for (long i = 0; i < m_k; i++) {
+                    runs[i] = m_runs[i] + m_begin[i];
+                    lengths[i] = m_end[i] - m_begin[i];
+                }
+                multiway_merge(&runs[0], &lengths[0], m_k, m_out + m_rank);
+                return;
+            }
+
+            // The splits of the middle rank lie between those of the slice ends.
+            long half = m_length / 2;
+            std::vector<long> mid(m_begin, m_begin + m_k);
+            std::vector<long> hi(m_end, m_end + m_k);
+            multisequence_select(m_runs, m_k, m_rank + half, &mid[0], &hi[0]);
+
+            MultiwayMergeTask<T> left(m_runs, m_k, m_begin, &mid[0], m_rank, half, m_out);
+            MultiwayMergeTask<T> right(m_runs, m_k, &mid[0], m_end, m_rank + half, m_length - half, m_out);
+            pool.fork(left);
+            right.compute(pool);
+            pool.join(left);
+        }
+
+    private:
+        const T* const* m_runs; ///< The whole runs.
+        long m_k; ///< The number of runs.
+        const long* m_begin; ///< The splits at the start of the slice.
+        const long* m_end; ///< The splits at the end of the slice.
+        long m_rank; ///< The index in the output of the start of the slice.
+        long m_length; ///< The number of elements of the slice.
+        T* m_out; ///< The whole output.
+    };
+
+
+    template <typename T>
+    void multiway_merge(const T* const* runs, const long* lengths, long k, T* out)
+    {
+        assert(k > 0);
+
+        if (k == 1) {
+            std::copy(runs[0], runs[0] + lengths[0], out);
+            return;
+        }
+        if (k == 2) {
+            merge_runs(runs[0], lengths[0], runs[1], lengths[1], out);
+            return;
+        }
+
+        LoserTree<T> tree(k);
+        std::vector<long> next(k, 1);
+        for (long i = 0; i < k; i++) {
+            if (lengths[i] > 0) {
+                tree.set(i, runs[i][0]);
+            }
+        }
+        tree.build();
+
+        while (!tree.empty()) {
+            long s = tree.winner();
+            *out++ = tree.top();
+            if (next[s] < lengths[s]) {
+                tree.replace_top(runs[s][next[s]++]);
+            } else {
+                tree.pop();
+            }
+        }
+    }
+
+
+    template <typename T>
+    void parallel_multiway_merge(const T* const* runs, const long* lengths, long k, T* out)
+    {
+        assert(k > 0);
+
+        long total = 0;
+        for (long i = 0; i < k; i++) {
+            total += lengths[i];
+        }
+        if (total <= parallel_multiway_merge_cutoff) {
+            multiway_merge(runs, lengths, k, out);
+            return;
+        }
+
+        ForkJoinPool pool;
+        parallel_multiway_merge(pool, runs, lengths, k, out);
+    }
+
+
+    /// \par References:
+    /// \li P. J. Varman, S. D. Scheufler, B. R. Iyer and G. R. Ricard. Merging Multiple Lists on
+    ///     Hierarchical-Memory Multiprocessors. JPDC 12(2), 1991.
+    /// \li J. Singler, P. Sanders and F. Putze. MCSTL: The Multi-core Standard Template Library.
+    ///     Euro-Par 2007.
+    template <typename T>
+    void parallel_multiway_merge(ForkJoinPool& pool, const T* const* runs, const long* lengths,
+                                 long k, T* out)
+    {
+        assert(k > 0);
+
+        std::vector<long> begin(k, 0);
+        std::vector<long> end(lengths, lengths + k);
+        long total = 0;
+        for (long i = 0; i < k; i++) {
+            total += lengths[i];
+        }
+
+        MultiwayMergeTask<T> task(runs, k, &begin[0], &end[0], 0L, total, out);
+        pool.invoke(task);
+    }
+
+
+    template <typename T>
+    void multisequence_select(const T* const* runs, const long* lengths, long k, long rank, long* splits)
+    {
+        assert(k > 0);
+
+        std::vector<long> hi(lengths, lengths + k);
+        std::fill(splits, splits + k, 0L);
+        multisequence_select(runs, k, rank, splits, &hi[0]);
+    }
+
+
+    /// The split of run i lies in [lo[i], hi[i]]. The middle element of the widest range is
+    /// taken as a pivot, and the elements ordered before it in the stable merge, by value
+    /// then by run, are counted in every run by binary search. If fewer than \b rank elements
+    /// precede the pivot, the pivot and those elements are before the splits, otherwise none
+    /// of the elements from the pivot on are. Every step halves the widest range, so there
+    /// are O(k log n) steps of O(k log n) time.
+    template <typename T>
+    void multisequence_select(const T* const* runs, long k, long rank, long* lo, long* hi)
+    {
+        std::vector<long> count(k);
+
+        for (;;) {
+            long p = -1;
+            for (long i = 0; i < k; i++) {
+                if (hi[i] > lo[i] && (p < 0 || hi[i] - lo[i] > hi[p] - lo[p])) {
+                    p = i;
+                }
+            }
+            if (p < 0) {
+                break;
+            }
+
+            long m = lo[p] + (hi[p] - lo[p]) / 2;
+            const T& pivot = runs[p][m];
+            long before = 0;
+            for (long i = 0; i < k; i++) {
+                if (i < p) {
+                    count[i] = std::upper_bound(runs[i] + lo[i], runs[i] + hi[i], pivot) - runs[i];
+                } else if (i > p) {
+                    count[i] = std::lower_bound(runs[i] + lo[i], runs[i] + hi[i], pivot) - runs[i];
+                } else {
+                    count[i] = m;
+                }
+                before += count[i];
+            }
+
+            if (before < rank) {
+                std::copy(count.begin(), count.end(), lo);
+                lo[p] = m + 1;
+            } else {
+                std::copy(count.begin(), count.end(), hi);
+                hi[p] = m;
+            }
+        }
+    }
+} // namespace algorithm
+
+#endif // KWAYMERGE_H
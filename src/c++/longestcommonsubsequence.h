@@ -27,6 +27,10 @@
 #define LONGESTCOMMONSUBSEQUENCE_H
 
 #include <cassert>
+#include <algorithm>
+#include <climits>
+#include <cstddef>
+#include <vector>
 
 namespace algorithm
 {
@@ -38,6 +42,60 @@ namespace algorithm
     /// \return The length of the longest common subsequence of <b>x</b> and <b>y</b>.
     template <typename T>
     long lcs_length(const T* x, long lx, const T* y, long ly);
+
+    /// \brief Compute the longest common subsequence length of the two byte strings, a
+    ///        machine word of cells of the dynamic programming table at a time.
+    /// \param[in] x The pointer to the first byte of the string <b>x</b>.
+    /// \param[in] lx The number of bytes in the string <b>x</b>.
+    /// \param[in] y The pointer to the first byte of the string <b>y</b>.
+    /// \param[in] ly The number of bytes in the string <b>y</b>.
+    /// \return The length of the longest common subsequence of <b>x</b> and <b>y</b>.
+    long lcs_length(const char* x, long lx, const char* y, long ly);
+
+    /// \brief Compute the longest common subsequence length of the two byte strings, a
+    ///        machine word of cells of the dynamic programming table at a time.
+    long lcs_length(const unsigned char* x, long lx, const unsigned char* y, long ly);
+
+    /// \brief Compute a longest common subsequence of the two sequences as the pairs of
+    ///        indexes of its elements in <b>x</b> and <b>y</b>, in O(lx + ly) space.
+    /// \param[in] x The pointer to the first element of the sequence <b>x</b>.
+    /// \param[in] lx The number of elements in the sequence <b>x</b>.
+    /// \param[in] y The pointer to the first element of the sequence <b>y</b>.
+    /// \param[in] ly The number of elements in the sequence <b>y</b>.
+    /// \param[out] xindex The increasing indexes in <b>x</b> of the elements of the subsequence,
+    ///             room for min(lx, ly) of them.
+    /// \param[out] yindex The increasing indexes in <b>y</b> of the elements of the subsequence,
+    ///             room for min(lx, ly) of them.
+    /// \return The length of the longest common subsequence, the number of indexes stored.
+    template <typename T>
+    long lcs_alignment(const T* x, long lx, const T* y, long ly, long* xindex, long* yindex);
+
+    /// \brief The operation of a DiffHunk.
+    typedef enum {
+        DIFF_KEEP, ///< The elements are in both sequences.
+        DIFF_DELETE, ///< The elements of <b>x</b> are not in <b>y</b>.
+        DIFF_INSERT ///< The elements of <b>y</b> are not in <b>x</b>.
+    } DiffOperation;
+
+    /// \brief A run of elements kept, deleted from <b>x</b> or inserted from <b>y</b>.
+    typedef struct {
+        DiffOperation op; ///< The operation.
+        long x; ///< The index in <b>x</b> of the first element, or where the elements are inserted.
+        long y; ///< The index in <b>y</b> of the first element, or where the elements were deleted.
+        long length; ///< The number of elements.
+    } DiffHunk;
+
+    /// \brief Compute the edit script turning <b>x</b> into <b>y</b> with the fewest insertions
+    ///        and deletions, from a longest common subsequence.
+    /// \param[in] x The pointer to the first element of the sequence <b>x</b>.
+    /// \param[in] lx The number of elements in the sequence <b>x</b>.
+    /// \param[in] y The pointer to the first element of the sequence <b>y</b>.
+    /// \param[in] ly The number of elements in the sequence <b>y</b>.
+    /// \param[out] script The hunks in order. The deletions come before the insertions
+    ///             between two runs of kept elements.
+    template <typename T>
+    void diff(const T* x, long lx, const T* y, long ly, std::vector<DiffHunk>& script);
+
 } // namespace algorithm
 
 
@@ -47,13 +105,32 @@ namespace algorithm
 
 namespace algorithm
 {
+    template <bool Reverse, typename T>
+    static void lcs_row(const T* x, long lx, const T* y, long ly, long* c);
+
+    static inline long lcs_length_bits(const unsigned char* x, long lx, const unsigned char* y, long ly);
+
+    template <typename T>
+    static long lcs_common_prefix(const T* x, long lx, const T* y, long ly);
+
+    template <typename T>
+    static long lcs_common_suffix(const T* x, long lx, const T* y, long ly);
+
+    static inline long lcs_split(const long* forward, const long* backward, long ly);
+
+    template <typename T>
+    static long lcs_alignment(const T* x, long lx, long x0, const T* y, long ly, long y0,
+                              long* xindex, long* yindex, long* rows);
+
+    static inline void diff_script(const long* xindex, const long* yindex, long n, long lx, long ly,
+                                   std::vector<DiffHunk>& script);
+
+
     /// Compute the LCS length using O(lx + ly) space and O(lx * ly) time.
     template <typename T>
     long lcs_length(const T* x, long lx, const T* y, long ly)
     {
         long length;
-        long cik;
-        long next_cik;
 
         if (lx == 0 || ly == 0) {
             return 0;
@@ -61,21 +138,42 @@ namespace algorithm
 
         long* c = new long[ly + 1];
         assert(c != NULL);
+        lcs_row<false>(x, lx, y, ly, c);
+
+        length = c[ly];
+        delete[] c;
+        return length;
+    }
+
+
+    /// Fill c[k] with the LCS length of \b x and the first \b k elements of \b y, or with
+    /// \b Reverse, of \b x and the last \b k elements of \b y, both sequences read backward.
+    template <bool Reverse, typename T>
+    void lcs_row(const T* x, long lx, const T* y, long ly, long* c)
+    {
+        long cik;
+        long next_cik;
+
         for (long i = 0; i < ly + 1; ++i) {
             c[i] = 0;
         }
+        if (ly == 0) {
+            return;
+        }
 
         for (long i = 0; i < lx; ++i) {
+            const T& xi = Reverse ? x[lx-1-i] : x[i];
+
             // k = 0, c[0] == 0
             next_cik = c[1];
-            if (x[i] == y[0]) {
+            if (xi == (Reverse ? y[ly-1] : y[0])) {
                 c[1] = 1;
             }
             cik = next_cik;
 
             for (long k = 1; k < ly; ++k) {
                 next_cik = c[k+1];
-                if (x[i] == y[k]) {
+                if (xi == (Reverse ? y[ly-1-k] : y[k])) {
                     c[k+1] = cik + 1;
                 } else if (c[k] >= c[k+1]) {
                     c[k+1] = c[k];
@@ -83,11 +181,243 @@ namespace algorithm
                 cik = next_cik;
             }
         }
+    }
 
-        length = c[ly];
-        delete[] c;
+
+    inline long lcs_length(const char* x, long lx, const char* y, long ly)
+    {
+        return lcs_length_bits(reinterpret_cast<const unsigned char*>(x), lx,
+                               reinterpret_cast<const unsigned char*>(y), ly);
+    }
+
+
+    inline long lcs_length(const unsigned char* x, long lx, const unsigned char* y, long ly)
+    {
+        return lcs_length_bits(x, lx, y, ly);
+    }
+
+
+    /// Bit k of V is set when the row of the table does not step up at column k, so the LCS
+    /// length is the number of clear bits. With the mask M of the columns where y matches
+    /// the next byte of x, the next row is V' = (V + (V & M)) | (V & ~M): the addition turns
+    /// the lowest set bit of V before each match into a step up, and its carry propagates
+    /// from word to word. The match masks of all the bytes are set up once from y, so each
+    /// byte of x costs O(ly / 64) word operations instead of O(ly) cell updates.
+    /// \par References:
+    /// \li L. Allison and T. I. Dix. A Bit-String Longest-Common-Subsequence Algorithm.
+    ///     Information Processing Letters, 23(6), 1986.
+    /// \li H. Hyyro. Bit-Parallel LCS-length Computation Revisited. AWOCA 2004.
+    long lcs_length_bits(const unsigned char* x, long lx, const unsigned char* y, long ly)
+    {
+        const long bits = sizeof(unsigned long) * CHAR_BIT;
+
+        if (lx == 0 || ly == 0) {
+            return 0;
+        }
+
+        long words = (ly + bits - 1) / bits;
+        std::vector<unsigned long> match(256 * words, 0UL);
+        for (long k = 0; k < ly; ++k) {
+            match[y[k] * words + k / bits] |= 1UL << (k % bits);
+        }
+
+        std::vector<unsigned long> v(words, ~0UL);
+        if (words == 1) {
+            unsigned long v0 = ~0UL;
+            for (long i = 0; i < lx; ++i) {
+                unsigned long m = match[x[i]];
+                unsigned long u = v0 & m;
+                v0 = (v0 + u) | (v0 - u);
+            }
+            v[0] = v0;
+        } else {
+            for (long i = 0; i < lx; ++i) {
+                const unsigned long* m = &match[x[i] * words];
+                unsigned long carry = 0;
+                for (long w = 0; w < words; ++w) {
+                    unsigned long vw = v[w];
+                    unsigned long u = vw & m[w];
+                    unsigned long sum = vw + u;
+                    unsigned long next = (sum < vw);
+                    sum += carry;
+                    next |= (sum < carry);
+                    v[w] = sum | (vw - u);
+                    carry = next;
+                }
+            }
+        }
+
+        long length = 0;
+        for (long w = 0; w < words; ++w) {
+            unsigned long zeros = ~v[w];
+            if (w == words - 1 && ly % bits != 0) {
+                zeros &= (1UL << (ly % bits)) - 1;
+            }
+            length += __builtin_popcountl(zeros);
+        }
         return length;
     }
+
+
+    template <typename T>
+    long lcs_alignment(const T* x, long lx, const T* y, long ly, long* xindex, long* yindex)
+    {
+        assert(lx >= 0 && ly >= 0);
+
+        return lcs_alignment(x, lx, 0L, y, ly, 0L, xindex, yindex, static_cast<long*>(NULL));
+    }
+
+
+    template <typename T>
+    long lcs_common_prefix(const T* x, long lx, const T* y, long ly)
+    {
+        long n = 0;
+        while (n < lx && n < ly && x[n] == y[n]) {
+            n++;
+        }
+        return n;
+    }
+
+
+    template <typename T>
+    long lcs_common_suffix(const T* x, long lx, const T* y, long ly)
+    {
+        long n = 0;
+        while (n < lx && n < ly && x[lx-1-n] == y[ly-1-n]) {
+            n++;
+        }
+        return n;
+    }
+
+
+    /// The first column \b k of \b y maximizing the LCS length through it, given the forward
+    /// row of the first half of \b x and the backward row of its second half.
+    long lcs_split(const long* forward, const long* backward, long ly)
+    {
+        long split = 0;
+        long best = -1;
+        for (long k = 0; k <= ly; ++k) {
+            if (forward[k] + backward[ly-k] > best) {
+                best = forward[k] + backward[ly-k];
+                split = k;
+            }
+        }
+        return split;
+    }
+
+
+    /// Hirschberg's algorithm. The common prefix and suffix are matched first. Then the
+    /// forward row of the first half of \b x and the backward row of its second half give
+    /// the LCS length through every column \b k of \b y, and the best \b k splits \b y so that
+    /// the two halves are aligned independently. Each level of the recursion computes rows
+    /// of lx * ly cells in total, halving every time, so the time is O(lx * ly), and the two
+    /// rows need O(ly) space, reused by the whole recursion.
+    /// \par References:
+    /// \li D. S. Hirschberg. A Linear Space Algorithm for Computing Maximal Common
+    ///     Subsequences. Communications of the ACM, 18(6), 1975.
+    template <typename T>
+    long lcs_alignment(const T* x, long lx, long x0, const T* y, long ly, long y0,
+                       long* xindex, long* yindex, long* rows)
+    {
+        long n = lcs_common_prefix(x, lx, y, ly);
+        for (long i = 0; i < n; ++i) {
+            xindex[i] = x0 + i;
+            yindex[i] = y0 + i;
+        }
+        x += n;
+        y += n;
+        x0 += n;
+        y0 += n;
+        lx -= n;
+        ly -= n;
+        long suffix = lcs_common_suffix(x, lx, y, ly);
+        lx -= suffix;
+        ly -= suffix;
+
+        if (lx == 1) {
+            for (long k = 0; k < ly; ++k) {
+                if (x[0] == y[k]) {
+                    xindex[n] = x0;
+                    yindex[n] = y0 + k;
+                    n++;
+                    break;
+                }
+            }
+        } else if (lx > 1 && ly > 0) {
+            long mid = lx / 2;
+            std::vector<long> local;
+            if (rows == NULL) {
+                local.resize(2 * (ly + 1));
+                rows = &local[0];
+            }
+            long* forward = rows;
+            long* backward = rows + ly + 1;
+
+            lcs_row<false>(x, mid, y, ly, forward);
+            lcs_row<true>(x + mid, lx - mid, y, ly, backward);
+            long split = lcs_split(forward, backward, ly);
+
+            n += lcs_alignment(x, mid, x0, y, split, y0, xindex + n, yindex + n, rows);
+            n += lcs_alignment(x + mid, lx - mid, x0 + mid, y + split, ly - split, y0 + split,
+                               xindex + n, yindex + n, rows);
+        }
+
+        for (long s = 0; s < suffix; ++s) {
+            xindex[n] = x0 + lx + s;
+            yindex[n] = y0 + ly + s;
+            n++;
+        }
+        return n;
+    }
+
+
+    template <typename T>
+    void diff(const T* x, long lx, const T* y, long ly, std::vector<DiffHunk>& script)
+    {
+        std::vector<long> xindex(std::min(lx, ly) + 1);
+        std::vector<long> yindex(std::min(lx, ly) + 1);
+
+        long n = lcs_alignment(x, lx, y, ly, &xindex[0], &yindex[0]);
+        diff_script(&xindex[0], &yindex[0], n, lx, ly, script);
+    }
+
+
+    /// Between two runs of matched elements, the unmatched elements of \b x are deleted and
+    /// those of \b y are inserted.
+    void diff_script(const long* xindex, const long* yindex, long n, long lx, long ly,
+                     std::vector<DiffHunk>& script)
+    {
+        long i = 0;
+        long j = 0;
+        long p = 0;
+
+        script.clear();
+        for (;;) {
+            long xi = (p < n) ? xindex[p] : lx;
+            long yj = (p < n) ? yindex[p] : ly;
+            if (xi > i) {
+                DiffHunk hunk = { DIFF_DELETE, i, j, xi - i };
+                script.push_back(hunk);
+            }
+            if (yj > j) {
+                DiffHunk hunk = { DIFF_INSERT, xi, j, yj - j };
+                script.push_back(hunk);
+            }
+            if (p == n) {
+                break;
+            }
+
+            long run = 1;
+            while (p + run < n && xindex[p+run] == xi + run && yindex[p+run] == yj + run) {
+                run++;
+            }
+            DiffHunk hunk = { DIFF_KEEP, xi, yj, run };
+            script.push_back(hunk);
+            i = xi + run;
+            j = yj + run;
+            p += run;
+        }
+    }
 } // namespace algorithm
 
 #endif // LONGESTCOMMONSUBSEQUENCE_H
@@ -0,0 +1,242 @@
+/*
+# Copyright (c) 2008 Chung Shin Yee <cshinyee@gmail.com>
+#
+#       http://github.com/xman
+#       http://myxman.org
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License as
+# published by the Free Software Foundation; either version 2 of the
+# License, or (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+# USA.
+#
+# The GNU General Public License is contained in the file COPYING.
+#
+*/
+
+#ifndef LOSERTREE_H
+#define LOSERTREE_H
+
+#include <cassert>
+#include <algorithm>
+#include <vector>
+
+namespace algorithm
+{
+    /// \brief A tournament tree of losers over the current keys of \b k sorted sources.<br>
+    ///        Every internal node keeps the loser of the match played there, so replacing the
+    ///        winner's key replays a single leaf-to-root path of log2(k) comparisons.
+    ///        Ties go to the source with the smaller index, which keeps k-way merges stable.<br>
+    ///        Only the sources that are not exhausted have a leaf, so the matches never test
+    ///        for exhaustion: the tree is rebuilt in O(k) time when a source runs out instead.
+    template <typename T>
+    class LoserTree
+    {
+    public:
+        /// \brief Construct a tree over \b k sources, all of them exhausted.
+        /// \param[in] k The number of sources.
+        explicit LoserTree(long k);
+        ~LoserTree(void);
+
+        /// \brief Set the key of \b source before build().
+        void set(long source, const T& key);
+
+        /// \brief Play all the matches once the keys of the non-exhausted sources are set.
+        void build(void);
+
+        /// \brief Is every source exhausted?
+        bool empty(void) const;
+
+        /// \brief Get the source holding the smallest key.
+        /// \warning It's an error to call winner() when the tree is empty.
+        long winner(void) const;
+
+        /// \brief Get the smallest key.
+        const T& top(void) const;
+
+        /// \brief Replace the key of the winner with the next key of its source.
+        void replace_top(const T& key);
+
+        /// \brief Mark the source of the winner as exhausted.
+        void pop(void);
+
+    private:
+        /// \brief Does leaf \b a win against leaf \b b?
+        bool beats(long a, long b) const;
+
+        /// \brief Play all the matches between the m_n leaves.
+        void play(void);
+
+        /// \brief Replay the matches from the leaf of the winner up to the root.
+        void replay(void);
+
+        long m_k; ///< The number of sources.
+        long m_n; ///< The number of leaves, the sources not exhausted.
+        std::vector<T> m_keys; ///< The current key of each leaf, of each source before build().
+        std::vector<char> m_exhausted; ///< Is the source out of keys? Only used before build().
+        std::vector<long> m_source; ///< The source of each leaf, in increasing order.
+        std::vector<long> m_loser; ///< The leaf losing at each internal node, the overall winner at index 0.
+    };
+} // namespace algorithm
+
+
+// ===================================================================
+// Implementation
+// ===================================================================
+
+namespace algorithm
+{
+    template <typename T>
+    LoserTree<T>::LoserTree(long k) :
+        m_k(k), m_n(0), m_keys(k), m_exhausted(k, true), m_source(k, 0), m_loser(k, 0)
+    {
+        assert(k > 0);
+    }
+
+
+    template <typename T>
+    LoserTree<T>::~LoserTree(void)
+    {
+    }
+
+
+    template <typename T>
+    void LoserTree<T>::set(long source, const T& key)
+    {
+        assert(source >= 0 && source < m_k);
+
+        m_keys[source] = key;
+        m_exhausted[source] = false;
+    }
+
+
+    /// \par References:
+    /// The Art of Computer Programming Volume 3: Sorting and Searching - Donald E. Knuth
+    template <typename T>
+    void LoserTree<T>::build(void)
+    {
+        // The keys move down to the leaves, whose index never exceeds their source's.
+        m_n = 0;
+        for (long i = 0; i < m_k; i++) {
+            if (!m_exhausted[i]) {
+                if (m_n != i) {
+                    m_keys[m_n] = m_keys[i];
+                }
+                m_source[m_n] = i;
+                m_n++;
+            }
+        }
+        play();
+    }
+
+
+    template <typename T>
+    void LoserTree<T>::play(void)
+    {
+        // Leaves are the nodes m_n .. 2*m_n-1; winner[n] is the winner below node n.
+        std::vector<long> winner(2 * m_n);
+        for (long i = 0; i < m_n; i++) {
+            winner[m_n + i] = i;
+        }
+        for (long n = m_n - 1; n >= 1; n--) {
+            long a = winner[2*n];
+            long b = winner[2*n + 1];
+            if (beats(a, b)) {
+                winner[n] = a;
+                m_loser[n] = b;
+            } else {
+                winner[n] = b;
+                m_loser[n] = a;
+            }
+        }
+        m_loser[0] = (m_n <= 1) ? 0 : winner[1];
+    }
+
+
+    template <typename T>
+    inline bool LoserTree<T>::empty(void) const
+    {
+        return m_n == 0;
+    }
+
+
+    template <typename T>
+    inline long LoserTree<T>::winner(void) const
+    {
+        assert(!empty());
+
+        return m_source[m_loser[0]];
+    }
+
+
+    template <typename T>
+    inline const T& LoserTree<T>::top(void) const
+    {
+        assert(!empty());
+
+        return m_keys[m_loser[0]];
+    }
+
+
+    template <typename T>
+    inline void LoserTree<T>::replace_top(const T& key)
+    {
+        m_keys[m_loser[0]] = key;
+        replay();
+    }
+
+
+    /// The leaf of the winner is removed and the remaining ones, still in source order,
+    /// play again, once per source over the whole merge.
+    template <typename T>
+    void LoserTree<T>::pop(void)
+    {
+        assert(!empty());
+
+        for (long i = m_loser[0]; i + 1 < m_n; i++) {
+            m_keys[i] = m_keys[i+1];
+            m_source[i] = m_source[i+1];
+        }
+        m_n--;
+        play();
+    }
+
+
+    template <typename T>
+    inline bool LoserTree<T>::beats(long a, long b) const
+    {
+        return (m_keys[a] <= m_keys[b]) & ((a < b) | !(m_keys[b] <= m_keys[a]));
+    }
+
+
+    /// The winner and the loser of each match are selected with masks instead of branches,
+    /// so that the unpredictable outcomes of the comparisons cost no mispredictions.
+    template <typename T>
+    inline void LoserTree<T>::replay(void)
+    {
+        const T* keys = &m_keys[0];
+        long* loser = &m_loser[0];
+        long w = loser[0];
+        const T* wkey = &keys[w];
+        for (long n = (w + m_n) / 2; n >= 1; n /= 2) {
+            long l = loser[n];
+            const T* lkey = &keys[l];
+            long swap = -(long)((*lkey <= *wkey) & ((l < w) | !(*wkey <= *lkey)));
+            loser[n] = (w & swap) | (l & ~swap);
+            w = (l & swap) | (w & ~swap);
+            wkey = &keys[w];
+        }
+        loser[0] = w;
+    }
+} // namespace algorithm
+
+#endif // LOSERTREE_H
@@ -0,0 +1,187 @@
+/*
+# Copyright (c) 2008 Chung Shin Yee <cshinyee@gmail.com>
+#
+#       http://github.com/xman
+#       http://myxman.org
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License as
+# published by the Free Software Foundation; either version 2 of the
+# License, or (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+# USA.
+#
+# The GNU General Public License is contained in the file COPYING.
+#
+*/
+
+// A read-only memory mapping of a whole file.
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cassert>
+#include <algorithm>
+#include <climits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace algorithm
+{
+    /// \brief A file mapped read-only into memory, so its bytes are searched in place without
+    ///        being copied into a buffer. The mapping is released by close() or the destructor.
+    class MappedFile
+    {
+    public:
+        MappedFile(void);
+        ~MappedFile(void);
+
+        /// \brief Map the file at \b path, releasing the previous mapping if any.
+        /// \param[in] path The path of the file.
+        /// \return true if the file is mapped, false on an I/O error.
+        bool open(const char* path);
+
+        /// \brief Map the bytes of the file at \b path from \b offset, \b length of them or up to
+        ///        the end of the file, releasing the previous mapping if any.<br>
+        ///        Files larger than the address space are mapped a window at a time.
+        /// \param[in] path The path of the file.
+        /// \param[in] offset The position of the window in the file, a multiple of the page size.
+        /// \param[in] length The maximum number of bytes of the window.
+        /// \return true if the window is mapped, false on an I/O error.
+        bool open(const char* path, long offset, long length);
+
+        /// \brief Release the mapping.
+        void close(void);
+
+        /// \brief Tell the kernel how the mapping will be accessed.
+        /// \param[in] advice An madvise() advice such as MADV_SEQUENTIAL or MADV_WILLNEED.
+        /// \return true if the advice is taken.
+        bool advise(int advice);
+
+        /// \brief Get the bytes of the file, NULL when it is empty or not mapped.
+        const char* data(void) const;
+
+        /// \brief Get the number of bytes mapped.
+        long size(void) const;
+
+        /// \brief Get the number of bytes of the whole file.
+        long file_size(void) const;
+
+    private:
+        MappedFile(const MappedFile& rhs);
+        MappedFile& operator=(const MappedFile& rhs);
+
+        const char* m_data; ///< The mapping.
+        long m_size; ///< The length of the mapping.
+        long m_file_size; ///< The length of the file.
+    };
+} // namespace algorithm
+
+
+// ===================================================================
+// Implementation
+// ===================================================================
+
+namespace algorithm
+{
+    inline MappedFile::MappedFile(void) : m_data(NULL), m_size(0), m_file_size(0)
+    {
+    }
+
+
+    inline MappedFile::~MappedFile(void)
+    {
+        close();
+    }
+
+
+    inline bool MappedFile::open(const char* path)
+    {
+        return open(path, 0, LONG_MAX);
+    }
+
+
+    /// An empty window cannot be mapped; it is opened with no data.
+    inline bool MappedFile::open(const char* path, long offset, long length)
+    {
+        assert(offset >= 0 && offset % sysconf(_SC_PAGESIZE) == 0);
+        assert(length >= 0);
+
+        close();
+
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            ::close(fd);
+            return false;
+        }
+
+        bool ok = true;
+        long size = (offset < st.st_size) ? std::min(length, static_cast<long>(st.st_size) - offset) : 0;
+        m_file_size = st.st_size;
+        if (size > 0) {
+            void* p = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, offset);
+            if (p == MAP_FAILED) {
+                ok = false;
+            } else {
+                m_data = static_cast<const char*>(p);
+                m_size = size;
+            }
+        }
+        ::close(fd);
+        return ok;
+    }
+
+
+    inline void MappedFile::close(void)
+    {
+        if (m_data != NULL) {
+            munmap(const_cast<char*>(m_data), m_size);
+        }
+        m_data = NULL;
+        m_size = 0;
+        m_file_size = 0;
+    }
+
+
+    inline bool MappedFile::advise(int advice)
+    {
+        if (m_data == NULL) {
+            return true;
+        }
+        return madvise(const_cast<char*>(m_data), m_size, advice) == 0;
+    }
+
+
+    inline const char* MappedFile::data(void) const
+    {
+        return m_data;
+    }
+
+
+    inline long MappedFile::size(void) const
+    {
+        return m_size;
+    }
+
+
+    inline long MappedFile::file_size(void) const
+    {
+        return m_file_size;
+    }
+} // namespace algorithm
+
+#endif // MAPPEDFILE_H
@@ -27,6 +27,10 @@
 #define MERGESORT_H
 
 #include <cassert>
+#include <algorithm>
+#include "insertionsort.h"
+#include "move.h"
+#include "sortnetwork.h"
 
 namespace algorithm
 {
@@ -44,6 +48,14 @@ namespace algorithm
     /// \param[in] iend The index of the last elements to sort.
     template <typename T>
     void merge_sort(T* data, long istart, long iend);
+
+    /// \brief Sort the \b length elements using the Merge Sort algorithm with a caller-supplied buffer.
+    /// \param T The data type of the elements.
+    /// \param[in,out] data The pointer to the list of elements.
+    /// \param[in] length The number of elements.
+    /// \param[out] buffer The scratch space of at least \b length elements.
+    template <typename T>
+    void merge_sort(T* data, long length, T* buffer);
 } // namespace algorithm
 
 
@@ -53,8 +65,19 @@ namespace algorithm
 
 namespace algorithm
 {
+    /// The runs with at most this number of elements are sorted by a sorting network,
+    /// or by Insertion Sort when there is none.
+    static const long merge_sort_run = 32;
+
+
+    template <typename T>
+    static void merge_sort_runs(T* data, long length);
+
+    template <typename T>
+    static T* merge_sort_passes(T* src, T* dest, long length);
+
     template <typename T>
-    static void merge(T* data, long istart, long mid, long iend);
+    static void merge(T* src, long istart, long mid, long iend, T* dest);
 
 
     template <typename T>
@@ -66,64 +89,108 @@ namespace algorithm
     }
 
 
-    /// \par References:
-    /// Computer Algorithms Introduction to Design and Analysis - Sara Baase & Allen Van Gelder
     template <typename T>
     void merge_sort(T* data, long istart, long iend)
     {
         assert(iend - istart + 1 > 0);
 
-        if (istart < iend) {
-            long mid = (istart + iend) / 2;
-            merge_sort(data, istart, mid);
-            merge_sort(data, mid+1, iend);
-            merge(data, istart, mid, iend);
+        long length = iend - istart + 1;
+        if (length <= merge_sort_run) {
+            insertion_sort(data, istart, iend);
+            return;
+        }
+
+        // The buffer is raw storage: it takes the elements by move construction, so that T
+        // needs no default constructor, and the passes start from it.
+        T* buffer = allocate_uninitialized<T>(length);
+        uninitialized_move(data + istart, data + iend + 1, buffer);
+
+        merge_sort_runs(buffer, length);
+        T* sorted = merge_sort_passes(buffer, data + istart, length);
+        if (sorted != data + istart) {
+            move_forward(sorted, sorted + length, data + istart);
         }
+
+        deallocate_uninitialized(buffer, length);
     }
 
 
+    /// Bottom-up merge sort. Runs of merge_sort_run elements are sorted in place, then
+    /// merged pairwise alternating between \b data and \b buffer, so no allocation
+    /// happens during the sort. Two runs already in order are moved without merging.
+    /// \par References:
+    /// Computer Algorithms Introduction to Design and Analysis - Sara Baase & Allen Van Gelder
     template <typename T>
-    void merge(T* data, long istart, long mid, long iend)
+    void merge_sort(T* data, long length, T* buffer)
     {
-        long n = iend - istart + 1;
-        long k = mid - istart + 1;
-        long m = n - k;
-        long ia = 0, ib = 0, ic = 0;
-
-        assert(istart <= mid && mid < iend);
+        assert(length > 0);
+        assert(buffer != NULL);
 
-        T* a = &data[istart];
-        T* b = &data[mid+1];
-        T* c = new T[n];
+        merge_sort_runs(data, length);
+        T* sorted = merge_sort_passes(data, buffer, length);
+        if (sorted != data) {
+            move_forward(sorted, sorted + length, data);
+        }
+    }
 
-        assert(c != NULL);
 
-        while (ia < k && ib < m) {
-            if (a[ia] <= b[ib]) {
-                c[ic] = a[ia];
-                ia++;
-                ic++;
-            } else {
-                c[ic] = b[ib];
-                ib++;
-                ic++;
+    template <typename T>
+    void merge_sort_runs(T* data, long length)
+    {
+        for (long i = 0; i < length; i += merge_sort_run) {
+            long iend = std::min(i + merge_sort_run, length) - 1;
+            if (!network_sort_stable(data + i, iend - i + 1)) {
+                insertion_sort(data, i, iend);
             }
         }
-        if (ia >= k) {
-            for (long i = 0; i < n - ic; i++) {
-                c[ic + i] = b[ib + i];
-            }
-        } else {
-            for (long i = 0; i < n - ic; i++) {
-                c[ic + i] = a[ia + i];
+    }
+
+
+    /// Merge the sorted runs of \b src pairwise, alternating with \b dest.
+    /// \return The array holding the sorted elements, \b src or \b dest.
+    template <typename T>
+    T* merge_sort_passes(T* src, T* dest, long length)
+    {
+        for (long width = merge_sort_run; width < length; width *= 2) {
+            for (long i = 0; i < length; i += 2*width) {
+                long mid = std::min(i + width, length);
+                long iend = std::min(i + 2*width, length) - 1;
+                if (mid > iend || src[mid-1] <= src[mid]) {
+                    move_forward(src + i, src + iend + 1, dest + i);
+                } else {
+                    merge(src, i, mid-1, iend, dest);
+                }
             }
+            std::swap(src, dest);
         }
+        return src;
+    }
+
+
+    /// Merge the sorted runs src[istart..mid] and src[mid+1..iend] into dest[istart..iend],
+    /// moving the elements.
+    template <typename T>
+    void merge(T* src, long istart, long mid, long iend, T* dest)
+    {
+        long ia = istart;
+        long ib = mid + 1;
+        long ic = istart;
 
-        for (long i = 0; i < n; i++) {
-            data[istart + i] = c[i];
+        assert(istart <= mid && mid < iend);
+
+        if (network_merge(src + istart, mid - istart + 1, src + mid + 1, iend - mid, dest + istart)) {
+            return;
         }
 
-        delete[] c;
+        while (ia <= mid && ib <= iend) {
+            if (src[ia] <= src[ib]) {
+                dest[ic++] = ALGORITHM_MOVE(src[ia++]);
+            } else {
+                dest[ic++] = ALGORITHM_MOVE(src[ib++]);
+            }
+        }
+        ic = move_forward(src + ia, src + mid + 1, dest + ic) - dest;
+        move_forward(src + ib, src + iend + 1, dest + ic);
     }
 } // namespace algorithm
 
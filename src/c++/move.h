@@ -0,0 +1,128 @@
+/*
+# Copyright (c) 2008 Chung Shin Yee <cshinyee@gmail.com>
+#
+#       http://github.com/xman
+#       http://myxman.org
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License as
+# published by the Free Software Foundation; either version 2 of the
+# License, or (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+# USA.
+#
+# The GNU General Public License is contained in the file COPYING.
+#
+*/
+
+#ifndef MOVE_H
+#define MOVE_H
+
+#include <cassert>
+#include <new>
+#include <algorithm>
+#if __cplusplus >= 201103L
+#include <utility>
+#endif
+
+/// \brief Move from \b x when the compiler supports rvalue references, copy otherwise.
+#if __cplusplus >= 201103L
+#define ALGORITHM_MOVE(x) std::move(x)
+#else
+#define ALGORITHM_MOVE(x) (x)
+#endif
+
+namespace algorithm
+{
+    /// \brief Move the elements from \b first to \b last, exclusive, to \b dest onwards.
+    /// \return The end of the destination range.
+    /// \warning \b dest must not lie in (first, last).
+    template <typename T>
+    T* move_forward(T* first, T* last, T* dest);
+
+    /// \brief Move the elements from \b first to \b last, exclusive, to the range ending at \b dest.
+    /// \return The start of the destination range.
+    /// \warning \b dest must not lie in (first, last].
+    template <typename T>
+    T* move_backward(T* first, T* last, T* dest);
+
+    /// \brief Get raw storage for \b length elements, none of them constructed.
+    template <typename T>
+    T* allocate_uninitialized(long length);
+
+    /// \brief Move-construct the elements from \b first to \b last, exclusive, into the raw
+    ///        storage starting at \b dest.
+    template <typename T>
+    void uninitialized_move(T* first, T* last, T* dest);
+
+    /// \brief Destroy the first \b length elements of \b buffer and release its storage.
+    template <typename T>
+    void deallocate_uninitialized(T* buffer, long length);
+} // namespace algorithm
+
+
+// ===================================================================
+// Implementation
+// ===================================================================
+
+namespace algorithm
+{
+    template <typename T>
+    T* move_forward(T* first, T* last, T* dest)
+    {
+#if __cplusplus >= 201103L
+        return std::move(first, last, dest);
+#else
+        return std::copy(first, last, dest);
+#endif
+    }
+
+
+    template <typename T>
+    T* move_backward(T* first, T* last, T* dest)
+    {
+#if __cplusplus >= 201103L
+        return std::move_backward(first, last, dest);
+#else
+        return std::copy_backward(first, last, dest);
+#endif
+    }
+
+
+    template <typename T>
+    T* allocate_uninitialized(long length)
+    {
+        assert(length > 0);
+
+        return static_cast<T*>(::operator new(length * sizeof(T)));
+    }
+
+
+    template <typename T>
+    void uninitialized_move(T* first, T* last, T* dest)
+    {
+        for (; first != last; ++first, ++dest) {
+            ::new (static_cast<void*>(dest)) T(ALGORITHM_MOVE(*first));
+        }
+    }
+
+
+    template <typename T>
+    void deallocate_uninitialized(T* buffer, long length)
+    {
+        for (long i = 0; i < length; i++) {
+            buffer[i].~T();
+        }
+        ::operator delete(buffer);
+    }
+} // namespace algorithm
+
+#endif // MOVE_H
@@ -0,0 +1,233 @@
+/*
+# Copyright (c) 2008 Chung Shin Yee <cshinyee@gmail.com>
+#
+#       http://github.com/xman
+#       http://myxman.org
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License as
+# published by the Free Software Foundation; either version 2 of the
+# License, or (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+# USA.
+#
+# The GNU General Public License is contained in the file COPYING.
+#
+*/
+
+// Longest common subsequence alignment and diff on all the processors.
+
+#ifndef PARALLELLONGESTCOMMONSUBSEQUENCE_H
+#define PARALLELLONGESTCOMMONSUBSEQUENCE_H
+
+#include <cassert>
+#include <algorithm>
+#include <vector>
+#include "forkjoin.h"
+#include "longestcommonsubsequence.h"
+
+namespace algorithm
+{
+    /// \brief Compute a longest common subsequence of the two sequences on all online processors.
+    template <typename T>
+    long parallel_lcs_alignment(const T* x, long lx, const T* y, long ly, long* xindex, long* yindex);
+
+    /// \brief Compute a longest common subsequence of the two sequences on the workers of
+    ///        \b pool, the two halves of every split concurrently.
+    /// \note The result is identical to lcs_alignment().
+    template <typename T>
+    long parallel_lcs_alignment(ForkJoinPool& pool, const T* x, long lx, const T* y, long ly,
+                                long* xindex, long* yindex);
+
+    /// \brief Compute the edit script turning <b>x</b> into <b>y</b> on the workers of \b pool.
+    /// \note The result is identical to diff().
+    template <typename T>
+    void parallel_diff(ForkJoinPool& pool, const T* x, long lx, const T* y, long ly,
+                       std::vector<DiffHunk>& script);
+} // namespace algorithm
+
+
+// ===================================================================
+// Implementation
+// ===================================================================
+
+namespace algorithm
+{
+    /// The subproblems of more than this number of table cells are split concurrently
+    /// by the parallel alignment.
+    static const long parallel_lcs_alignment_cutoff = 1L << 22;
+
+
+    template <typename T>
+    static long parallel_lcs_alignment(ForkJoinPool& pool, const T* x, long lx, long x0,
+                                       const T* y, long ly, long y0, long* xindex, long* yindex);
+
+
+    /// \brief Compute a row of the LCS table of \b x and \b y, forward or backward.
+    template <bool Reverse, typename T>
+    class LcsRowTask : public ForkJoinTask
+    {
+    public:
+        LcsRowTask(const T* x, long lx, const T* y, long ly, long* c) :
+            m_x(x), m_lx(lx), m_y(y), m_ly(ly), m_c(c)
+        {
+        }
+
+        void compute(ForkJoinPool& pool)
+        {
+            (void)pool;
+            lcs_row<Reverse>(m_x, m_lx, m_y, m_ly, m_c);
+        }
+
+    private:
+        const T* m_x;
+        long m_lx;
+        const T* m_y;
+        long m_ly;
+        long* m_c;
+    };
+
+
+    /// \brief Align \b x with \b y, whose first elements are at \b x0 and \b y0 in the whole
+    ///        sequences, into the indexes from \b xindex and \b yindex.
+    template <typename T>
+    class LcsAlignmentTask : public ForkJoinTask
+    {
+    public:
+        LcsAlignmentTask(const T* x, long lx, long x0, const T* y, long ly, long y0,
+                         long* xindex, long* yindex) :
+            m_x(x), m_lx(lx), m_x0(x0), m_y(y), m_ly(ly), m_y0(y0), m_xindex(xindex), m_yindex(yindex),
+            m_length(0)
+        {
+        }
+
+        void compute(ForkJoinPool& pool)
+        {
+            m_length = parallel_lcs_alignment(pool, m_x, m_lx, m_x0, m_y, m_ly, m_y0, m_xindex, m_yindex);
+        }
+
+        /// \brief Get the number of indexes stored by compute().
+        long length(void) const
+        {
+            return m_length;
+        }
+
+    private:
+        const T* m_x;
+        long m_lx;
+        long m_x0;
+        const T* m_y;
+        long m_ly;
+        long m_y0;
+        long* m_xindex;
+        long* m_yindex;
+        long m_length;
+    };
+
+
+    template <typename T>
+    long parallel_lcs_alignment(const T* x, long lx, const T* y, long ly, long* xindex, long* yindex)
+    {
+        if (lx * ly <= parallel_lcs_alignment_cutoff) {
+            return lcs_alignment(x, lx, y, ly, xindex, yindex);
+        }
+
+        ForkJoinPool pool;
+        return parallel_lcs_alignment(pool, x, lx, y, ly, xindex, yindex);
+    }
+
+
+    template <typename T>
+    long parallel_lcs_alignment(ForkJoinPool& pool, const T* x, long lx, const T* y, long ly,
+                                long* xindex, long* yindex)
+    {
+        assert(lx >= 0 && ly >= 0);
+
+        LcsAlignmentTask<T> task(x, lx, 0L, y, ly, 0L, xindex, yindex);
+        pool.invoke(task);
+        return task.length();
+    }
+
+
+    /// The steps of lcs_alignment(), except that the two rows and then the two halves of a
+    /// large subproblem are computed concurrently, each half with rows of its own. The
+    /// subproblems small enough are left to lcs_alignment(), so the splits are the same.
+    template <typename T>
+    long parallel_lcs_alignment(ForkJoinPool& pool, const T* x, long lx, long x0,
+                                const T* y, long ly, long y0, long* xindex, long* yindex)
+    {
+        if (lx * ly <= parallel_lcs_alignment_cutoff) {
+            return lcs_alignment(x, lx, x0, y, ly, y0, xindex, yindex, static_cast<long*>(NULL));
+        }
+
+        long n = lcs_common_prefix(x, lx, y, ly);
+        for (long i = 0; i < n; ++i) {
+            xindex[i] = x0 + i;
+            yindex[i] = y0 + i;
+        }
+        x += n;
+        y += n;
+        x0 += n;
+        y0 += n;
+        lx -= n;
+        ly -= n;
+        long suffix = lcs_common_suffix(x, lx, y, ly);
+        lx -= suffix;
+        ly -= suffix;
+
+        if (lx <= 1 || lx * ly <= parallel_lcs_alignment_cutoff) {
+            n += lcs_alignment(x, lx, x0, y, ly, y0, xindex + n, yindex + n, static_cast<long*>(NULL));
+        } else {
+            long mid = lx / 2;
+            std::vector<long> rows(2 * (ly + 1));
+            long* forward = &rows[0];
+            long* backward = &rows[ly + 1];
+
+            LcsRowTask<false, T> task(x, mid, y, ly, forward);
+            pool.fork(task);
+            lcs_row<true>(x + mid, lx - mid, y, ly, backward);
+            pool.join(task);
+
+            long split = lcs_split(forward, backward, ly);
+            long left = forward[split];
+
+            LcsAlignmentTask<T> first(x, mid, x0, y, split, y0, xindex + n, yindex + n);
+            LcsAlignmentTask<T> second(x + mid, lx - mid, x0 + mid, y + split, ly - split, y0 + split,
+                                       xindex + n + left, yindex + n + left);
+            pool.fork(first);
+            second.compute(pool);
+            pool.join(first);
+            assert(first.length() == left);
+            n += left + second.length();
+        }
+
+        for (long s = 0; s < suffix; ++s) {
+            xindex[n] = x0 + lx + s;
+            yindex[n] = y0 + ly + s;
+            n++;
+        }
+        return n;
+    }
+
+
+    template <typename T>
+    void parallel_diff(ForkJoinPool& pool, const T* x, long lx, const T* y, long ly,
+                       std::vector<DiffHunk>& script)
+    {
+        std::vector<long> xindex(std::min(lx, ly) + 1);
+        std::vector<long> yindex(std::min(lx, ly) + 1);
+
+        long n = parallel_lcs_alignment(pool, x, lx, y, ly, &xindex[0], &yindex[0]);
+        diff_script(&xindex[0], &yindex[0], n, lx, ly, script);
+    }
+} // namespace algorithm
+
+#endif // PARALLELLONGESTCOMMONSUBSEQUENCE_H
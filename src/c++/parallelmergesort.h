@@ -0,0 +1,242 @@
+/*
+# Copyright (c) 2008 Chung Shin Yee <cshinyee@gmail.com>
+#
+#       http://github.com/xman
+#       http://myxman.org
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License as
+# published by the Free Software Foundation; either version 2 of the
+# License, or (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+# USA.
+#
+# The GNU General Public License is contained in the file COPYING.
+#
+*/
+
+#ifndef PARALLELMERGESORT_H
+#define PARALLELMERGESORT_H
+
+#include <cassert>
+#include <algorithm>
+#include "forkjoin.h"
+#include "mergesort.h"
+#include "move.h"
+
+namespace algorithm
+{
+    /// \brief Sort the \b length elements using the Merge Sort algorithm on all online processors.
+    /// \param T The data type of the elements.
+    /// \param[in,out] data The pointer to the list of elements.
+    /// \param[in] length The number of elements.
+    template <typename T>
+    void parallel_merge_sort(T* data, long length);
+
+    /// \brief Sort the \b length elements using the Merge Sort algorithm on the workers of \b pool.
+    /// \param T The data type of the elements.
+    /// \param[in,out] pool The thread pool to run on.
+    /// \param[in,out] data The pointer to the list of elements.
+    /// \param[in] length The number of elements.
+    /// \note The sort is stable, and the result is identical to merge_sort().
+    template <typename T>
+    void parallel_merge_sort(ForkJoinPool& pool, T* data, long length);
+} // namespace algorithm
+
+
+// ===================================================================
+// Implementation
+// ===================================================================
+
+namespace algorithm
+{
+    /// The subarrays with at most this number of elements are sorted sequentially.
+    static const long parallel_merge_sort_cutoff = 8192;
+
+    /// The merges producing at most this number of elements are done sequentially.
+    static const long parallel_merge_cutoff = 8192;
+
+
+    template <typename T>
+    static long merge_corank(long k, const T* a, long na, const T* b, long nb);
+
+    template <typename S, typename T>
+    static void merge_runs(S* a, long na, S* b, long nb, T* out);
+
+
+    /// \brief Move the sorted runs \b a and \b b into \b out, splitting the output
+    ///        in half at its co-ranks until the pieces are small.
+    template <typename T>
+    class ParallelMergeTask : public ForkJoinTask
+    {
+    public:
+        ParallelMergeTask(T* a, long na, T* b, long nb, T* out) :
+            m_a(a), m_na(na), m_b(b), m_nb(nb), m_out(out)
+        {
+        }
+
+        void compute(ForkJoinPool& pool)
+        {
+            long n = m_na + m_nb;
+            if (n <= parallel_merge_cutoff) {
+                merge_runs(m_a, m_na, m_b, m_nb, m_out);
+                return;
+            }
+
+            long k = n / 2;
+            long i = merge_corank(k, m_a, m_na, m_b, m_nb);
+            long j = k - i;
+
+            ParallelMergeTask<T> left(m_a, i, m_b, j, m_out);
+            ParallelMergeTask<T> right(m_a + i, m_na - i, m_b + j, m_nb - j, m_out + k);
+            pool.fork(left);
+            right.compute(pool);
+            pool.join(left);
+        }
+
+    private:
+        T* m_a;
+        long m_na;
+        T* m_b;
+        long m_nb;
+        T* m_out;
+    };
+
+
+    /// \brief Sort \b data into \b data or \b buffer, whichever \b into_buffer selects,
+    ///        using the other array as scratch space.
+    template <typename T>
+    class ParallelMergeSortTask : public ForkJoinTask
+    {
+    public:
+        ParallelMergeSortTask(T* data, T* buffer, long length, bool into_buffer) :
+            m_data(data), m_buffer(buffer), m_length(length), m_into_buffer(into_buffer)
+        {
+        }
+
+        void compute(ForkJoinPool& pool)
+        {
+            if (m_length <= parallel_merge_sort_cutoff) {
+                merge_sort(m_data, m_length, m_buffer);
+                if (m_into_buffer) {
+                    move_forward(m_data, m_data + m_length, m_buffer);
+                }
+                return;
+            }
+
+            // Sort both halves into the other array, then merge them back.
+            long half = m_length / 2;
+            ParallelMergeSortTask<T> left(m_data, m_buffer, half, !m_into_buffer);
+            ParallelMergeSortTask<T> right(m_data + half, m_buffer + half, m_length - half, !m_into_buffer);
+            pool.fork(left);
+            right.compute(pool);
+            pool.join(left);
+
+            T* src = m_into_buffer ? m_data : m_buffer;
+            T* dest = m_into_buffer ? m_buffer : m_data;
+            ParallelMergeTask<T> merge(src, half, src + half, m_length - half, dest);
+            merge.compute(pool);
+        }
+
+    private:
+        T* m_data;
+        T* m_buffer;
+        long m_length;
+        bool m_into_buffer;
+    };
+
+
+    template <typename T>
+    void parallel_merge_sort(T* data, long length)
+    {
+        assert(length > 0);
+
+        if (length <= parallel_merge_sort_cutoff) {
+            merge_sort(data, length);
+            return;
+        }
+
+        ForkJoinPool pool;
+        parallel_merge_sort(pool, data, length);
+    }
+
+
+    /// \par References:
+    /// \li Introduction to Algorithms, 3rd ed., Chapter 27 - T. H. Cormen, C. E. Leiserson,
+    ///     R. L. Rivest & C. Stein
+    /// \li S. Odeh, O. Green, Z. Mwassi, O. Shmueli and Y. Birk. Merge Path - Parallel Merging
+    ///     Made Simple. IPDPS Workshops, 2012.
+    template <typename T>
+    void parallel_merge_sort(ForkJoinPool& pool, T* data, long length)
+    {
+        assert(length > 0);
+
+        // The buffer is raw storage taking the elements by move construction, as in
+        // merge_sort(), so that T needs no default constructor. The sort starts from it
+        // and ends in data.
+        T* buffer = allocate_uninitialized<T>(length);
+        uninitialized_move(data, data + length, buffer);
+
+        ParallelMergeSortTask<T> task(buffer, data, length, true);
+        pool.invoke(task);
+
+        deallocate_uninitialized(buffer, length);
+    }
+
+
+    /// Find how many of the first \b k merged elements come from \b a. Ties are taken
+    /// from \b a first, as merge_sort() does, so the merge stays stable.
+    template <typename T>
+    long merge_corank(long k, const T* a, long na, const T* b, long nb)
+    {
+        long lo = std::max(0L, k - nb);
+        long hi = std::min(k, na);
+
+        while (lo < hi) {
+            long i = lo + (hi - lo) / 2;
+            long j = k - i;
+            if (a[i] <= b[j-1]) {
+                lo = i + 1;
+            } else {
+                hi = i;
+            }
+        }
+        return lo;
+    }
+
+
+    /// The elements are moved from runs of T and copied from runs of const T.
+    template <typename S, typename T>
+    void merge_runs(S* a, long na, S* b, long nb, T* out)
+    {
+        long ia = 0, ib = 0;
+
+        if (network_merge<T>(a, na, b, nb, out)) {
+            return;
+        }
+
+        while (ia < na && ib < nb) {
+            if (a[ia] <= b[ib]) {
+                *out++ = ALGORITHM_MOVE(a[ia++]);
+            } else {
+                *out++ = ALGORITHM_MOVE(b[ib++]);
+            }
+        }
+        while (ia < na) {
+            *out++ = ALGORITHM_MOVE(a[ia++]);
+        }
+        while (ib < nb) {
+            *out++ = ALGORITHM_MOVE(b[ib++]);
+        }
+    }
+} // namespace algorithm
+
+#endif // PARALLELMERGESORT_H
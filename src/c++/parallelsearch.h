@@ -0,0 +1,251 @@
+/*
+# Copyright (c) 2008 Chung Shin Yee <cshinyee@gmail.com>
+#
+#       http://github.com/xman
+#       http://myxman.org
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License as
+# published by the Free Software Foundation; either version 2 of the
+# License, or (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+# USA.
+#
+# The GNU General Public License is contained in the file COPYING.
+#
+*/
+
+// String search over large buffers, such as mapped files, on all the processors.
+
+#ifndef PARALLELSEARCH_H
+#define PARALLELSEARCH_H
+
+#include <cassert>
+#include <algorithm>
+#include <vector>
+#include "forkjoin.h"
+#include "mappedfile.h"
+#include "stringsearch.h"
+
+namespace algorithm
+{
+    /// \brief Find the first occurrence of a pattern in the text on all online processors.
+    /// \param[in] search The pattern and its search algorithm.
+    /// \param[in] text The text string, which may contain NUL bytes.
+    /// \param[in] text_length The length of the text string.
+    /// \return The index in \b text where the first copy of the pattern begins.
+    /// \return -1 if no match is found.
+    long parallel_find(const StringSearch& search, const char* text, long text_length);
+
+    /// \brief Find the first occurrence of a pattern in a mapped file on all online processors.
+    long parallel_find(const StringSearch& search, const MappedFile& file);
+
+    /// \brief Find the first occurrence of a pattern in the text on the workers of \b pool.<br>
+    ///        The chunks starting after an occurrence already found are skipped.
+    long parallel_find(ForkJoinPool& pool, const StringSearch& search, const char* text, long text_length);
+
+    /// \brief Find every occurrence of a pattern in the text on all online processors.
+    /// \param[in] search The pattern and its search algorithm.
+    /// \param[in] text The text string, which may contain NUL bytes.
+    /// \param[in] text_length The length of the text string.
+    /// \param[out] offsets The indexes in \b text of the occurrences, in increasing order.
+    /// \return The number of occurrences.
+    long parallel_find_all(const StringSearch& search, const char* text, long text_length,
+                           std::vector<long>& offsets);
+
+    /// \brief Find every occurrence of a pattern in a mapped file on all online processors.
+    long parallel_find_all(const StringSearch& search, const MappedFile& file, std::vector<long>& offsets);
+
+    /// \brief Find every occurrence of a pattern in the text on the workers of \b pool.
+    /// \note The result is identical to StringSearch::find_all().
+    long parallel_find_all(ForkJoinPool& pool, const StringSearch& search, const char* text, long text_length,
+                           std::vector<long>& offsets);
+} // namespace algorithm
+
+
+// ===================================================================
+// Implementation
+// ===================================================================
+
+namespace algorithm
+{
+    /// The text is searched in chunks of this number of starting positions.
+    static const long parallel_search_chunk = 1L << 22;
+
+
+    /// \brief Collect the occurrences of a chunk as indexes in the whole text.
+    class ParallelSearchCollect
+    {
+    public:
+        ParallelSearchCollect(std::vector<long>& offsets, long base) : m_offsets(offsets), m_base(base)
+        {
+        }
+
+        void operator()(long offset)
+        {
+            m_offsets.push_back(m_base + offset);
+        }
+
+    private:
+        std::vector<long>& m_offsets; ///< The occurrences of the chunk.
+        long m_base; ///< The index in the text of the start of the chunk.
+    };
+
+
+    /// \brief Search the chunks \b lo to \b hi - 1, splitting them in half until one is left.
+    ///        Chunk c holds the occurrences starting in [c * parallel_search_chunk,
+    ///        (c + 1) * parallel_search_chunk) and is searched up to the length of the pattern
+    ///        minus one further, so every occurrence is found once, by a single chunk.
+    class ParallelSearchTask : public ForkJoinTask
+    {
+    public:
+        /// \param[in,out] first The first occurrence found so far, or \b text_length, when
+        ///                searching for the first occurrence only; NULL to find them all.
+        /// \param[out] found The occurrences of each chunk, when searching for them all.
+        ParallelSearchTask(const StringSearch& search, const char* text, long text_length,
+                           long lo, long hi, volatile long* first, std::vector<std::vector<long> >* found) :
+            m_search(search), m_text(text), m_text_length(text_length), m_lo(lo), m_hi(hi),
+            m_first(first), m_found(found)
+        {
+        }
+
+        void compute(ForkJoinPool& pool)
+        {
+            if (m_first != NULL && *m_first <= m_lo * parallel_search_chunk) {
+                return;
+            }
+            if (m_hi - m_lo == 1) {
+                search_chunk(m_lo);
+                return;
+            }
+
+            // The earlier half is searched first, since it may end the search of the later one.
+            long mid = m_lo + (m_hi - m_lo) / 2;
+            ParallelSearchTask left(m_search, m_text, m_text_length, m_lo, mid, m_first, m_found);
+            ParallelSearchTask right(m_search, m_text, m_text_length, mid, m_hi, m_first, m_found);
+            pool.fork(right);
+            left.compute(pool);
+            pool.join(right);
+        }
+
+    private:
+        void search_chunk(long c)
+        {
+            long begin = c * parallel_search_chunk;
+            long end = std::min(begin + parallel_search_chunk + m_search.length() - 1, m_text_length);
+
+            if (m_first == NULL) {
+                m_search.find_all(m_text + begin, end - begin, ParallelSearchCollect((*m_found)[c], begin));
+                return;
+            }
+
+            long p = m_search.find(m_text, end, begin);
+            long current = *m_first;
+            while (p >= 0 && p < current) {
+                long previous = __sync_val_compare_and_swap(m_first, current, p);
+                if (previous == current) {
+                    break;
+                }
+                current = previous;
+            }
+        }
+
+        const StringSearch& m_search; ///< The pattern.
+        const char* m_text; ///< The whole text.
+        long m_text_length; ///< The length of the whole text.
+        long m_lo; ///< The first chunk.
+        long m_hi; ///< The chunk after the last one.
+        volatile long* m_first; ///< The first occurrence found so far, NULL to find them all.
+        std::vector<std::vector<long> >* m_found; ///< The occurrences of each chunk.
+    };
+
+
+    inline long parallel_find(const StringSearch& search, const char* text, long text_length)
+    {
+        if (text_length <= parallel_search_chunk) {
+            return search.find(text, text_length);
+        }
+
+        ForkJoinPool pool;
+        return parallel_find(pool, search, text, text_length);
+    }
+
+
+    inline long parallel_find(const StringSearch& search, const MappedFile& file)
+    {
+        return parallel_find(search, file.data(), file.size());
+    }
+
+
+    inline long parallel_find(ForkJoinPool& pool, const StringSearch& search, const char* text, long text_length)
+    {
+        assert(text_length >= 0);
+
+        long nchunks = (text_length + parallel_search_chunk - 1) / parallel_search_chunk;
+        if (nchunks == 0) {
+            return -1;
+        }
+
+        volatile long first = text_length;
+        ParallelSearchTask task(search, text, text_length, 0, nchunks, &first, NULL);
+        pool.invoke(task);
+        return (first < text_length) ? first : -1;
+    }
+
+
+    inline long parallel_find_all(const StringSearch& search, const char* text, long text_length,
+                                  std::vector<long>& offsets)
+    {
+        if (text_length <= parallel_search_chunk) {
+            offsets.clear();
+            return search.find_all(text, text_length, ParallelSearchCollect(offsets, 0));
+        }
+
+        ForkJoinPool pool;
+        return parallel_find_all(pool, search, text, text_length, offsets);
+    }
+
+
+    inline long parallel_find_all(const StringSearch& search, const MappedFile& file, std::vector<long>& offsets)
+    {
+        return parallel_find_all(search, file.data(), file.size(), offsets);
+    }
+
+
+    /// The chunks keep their occurrences apart, and are concatenated in order at the end.
+    inline long parallel_find_all(ForkJoinPool& pool, const StringSearch& search, const char* text,
+                                  long text_length, std::vector<long>& offsets)
+    {
+        assert(text_length >= 0);
+
+        offsets.clear();
+        long nchunks = (text_length + parallel_search_chunk - 1) / parallel_search_chunk;
+        if (nchunks == 0) {
+            return 0;
+        }
+
+        std::vector<std::vector<long> > found(nchunks);
+        ParallelSearchTask task(search, text, text_length, 0, nchunks, NULL, &found);
+        pool.invoke(task);
+
+        size_t total = 0;
+        for (long c = 0; c < nchunks; c++) {
+            total += found[c].size();
+        }
+        offsets.reserve(total);
+        for (long c = 0; c < nchunks; c++) {
+            offsets.insert(offsets.end(), found[c].begin(), found[c].end());
+        }
+        return static_cast<long>(offsets.size());
+    }
+} // namespace algorithm
+
+#endif // PARALLELSEARCH_H
@@ -27,9 +27,19 @@
 #define QUICKSORT_H
 
 #include <cassert>
+#include <algorithm>
+#include "insertionsort.h"
+#include "heapsort.h"
+#include "sortnetwork.h"
 
 namespace algorithm
 {
+    /// \brief The partitioning scheme of quick_sort().
+    typedef enum {
+        QUICKSORT_THREE_WAY, ///< Dijkstra's three-way partition, which sets aside the keys equal to the pivot.
+        QUICKSORT_BLOCK ///< The BlockQuicksort partition, without branches on the comparisons.
+    } QuickSortPartition;
+
     /// \brief Sort the \b length elements using the Quick Sort algorithm.
     /// \param T The data type of the elements.
     /// \param[in,out] data The pointer to the list of elements.
@@ -44,6 +54,24 @@ namespace algorithm
     /// \param[in] iend The index of the last elements to sort.
     template <typename T>
     void quick_sort(T* data, long istart, long iend);
+
+    /// \brief Sort the \b length elements using the Quick Sort algorithm with the given partitioning scheme.
+    /// \param T The data type of the elements.
+    /// \param[in,out] data The pointer to the list of elements.
+    /// \param[in] length The number of elements.
+    /// \param[in] partition The partitioning scheme.
+    template <typename T>
+    void quick_sort(T* data, long length, QuickSortPartition partition);
+
+    /// \brief Sort the elements from \b istart to \b iend using the Quick Sort algorithm with the given
+    ///        partitioning scheme.
+    /// \param T The data type of the elements.
+    /// \param[in,out] data The pointer to the list of elements.
+    /// \param[in] istart The index of the first elements to sort.
+    /// \param[in] iend The index of the last elements to sort.
+    /// \param[in] partition The partitioning scheme.
+    template <typename T>
+    void quick_sort(T* data, long istart, long iend, QuickSortPartition partition);
 } // namespace algorithm
 
 
@@ -53,6 +81,41 @@ namespace algorithm
 
 namespace algorithm
 {
+    /// The partitions with at most this number of elements are left to Insertion Sort.
+    /// The types with a sorting network hand over up to network_sort_max elements to it instead.
+    static const long quick_sort_cutoff = 16;
+
+    /// The partitions with more than this number of elements select the pivot by ninther.
+    static const long quick_sort_ninther_threshold = 128;
+
+
+    /// The number of elements classified at once by the block partition.
+    static const long quick_sort_block = 64;
+
+
+    template <typename T>
+    static void introsort_loop(T* data, long istart, long iend, long depth_limit,
+                               QuickSortPartition partition, long root);
+
+    template <typename T>
+    static long median_of_three(const T* data, long a, long b, long c);
+
+    template <typename T>
+    static long select_pivot(const T* data, long istart, long iend);
+
+    template <typename T>
+    static void partition_three_way(T* data, long istart, long iend, long* lt, long* gt);
+
+    template <typename T>
+    static void partition_three_way(T* data, long istart, long iend, long pivot, long* lt, long* gt);
+
+    template <typename T>
+    static void partition_block(T* data, long istart, long iend, bool has_predecessor, long* lt, long* gt);
+
+    template <bool Equal, typename T>
+    static long partition_block(T* data, long istart, long iend);
+
+
     template <typename T>
     void quick_sort(T* data, long length)
     {
@@ -62,46 +125,239 @@ namespace algorithm
     }
 
 
+    /// The block partition is the default: it is the fastest on most inputs.
     template <typename T>
     void quick_sort(T* data, long istart, long iend)
     {
         assert(istart <= iend);
 
-        T pivot;
-        T temp;
-        long i, j, mid;
+        quick_sort(data, istart, iend, QUICKSORT_BLOCK);
+    }
+
+
+    template <typename T>
+    void quick_sort(T* data, long length, QuickSortPartition partition)
+    {
+        assert(length > 0);
+
+        quick_sort(data, 0, length-1, partition);
+    }
+
+
+    /// Introsort: quicksort with the selected partition, switching to Heap Sort when
+    /// the recursion gets deeper than 2 log2(n) and to Insertion Sort for small partitions.
+    /// Only the smaller partition is sorted recursively, so the stack depth is O(log n).
+    /// \par References:
+    /// \li D. R. Musser. Introspective Sorting and Selection Algorithms.
+    ///     Software: Practice and Experience, 27(8), 1997.
+    /// \li J. L. Bentley and M. D. McIlroy. Engineering a Sort Function.
+    ///     Software: Practice and Experience, 23(11), 1993.
+    template <typename T>
+    void quick_sort(T* data, long istart, long iend, QuickSortPartition partition)
+    {
+        assert(istart <= iend);
+
+        long depth_limit = 0;
+        for (long n = iend - istart + 1; n > 1; n >>= 1) {
+            depth_limit += 2;
+        }
+        introsort_loop(data, istart, iend, depth_limit, partition, istart);
+    }
+
+
+    /// \b root is the start of the whole range: the element before a partition other than
+    /// the first is no greater than any element of the partition.
+    template <typename T>
+    void introsort_loop(T* data, long istart, long iend, long depth_limit,
+                        QuickSortPartition partition, long root)
+    {
+        long lt, gt;
+
+        while (iend - istart + 1 > quick_sort_cutoff) {
+            if (iend - istart + 1 <= network_sort_max && network_sort(data + istart, iend - istart + 1)) {
+                return;
+            }
+            if (depth_limit == 0) {
+                heap_sort(data, istart, iend);
+                return;
+            }
+            depth_limit--;
+
+            if (partition == QUICKSORT_BLOCK) {
+                partition_block(data, istart, iend, istart > root, &lt, &gt);
+            } else {
+                partition_three_way(data, istart, iend, &lt, &gt);
+            }
+
+            // Recurse into the smaller partition and iterate on the larger one.
+            if (lt - istart < iend - gt) {
+                introsort_loop(data, istart, lt-1, depth_limit, partition, root);
+                istart = gt + 1;
+            } else {
+                introsort_loop(data, gt+1, iend, depth_limit, partition, root);
+                iend = lt - 1;
+            }
+        }
+        if (istart < iend && !network_sort(data + istart, iend - istart + 1)) {
+            insertion_sort(data, istart, iend);
+        }
+    }
+
 
-        // Select a pivot.
-        mid = (istart + iend + 1) / 2;
-        pivot = data[mid];
+    template <typename T>
+    long median_of_three(const T* data, long a, long b, long c)
+    {
+        if (!(data[b] <= data[a])) {
+            if (!(data[c] <= data[b])) return b;
+            return !(data[c] <= data[a]) ? c : a;
+        } else {
+            if (!(data[c] <= data[a])) return a;
+            return !(data[c] <= data[b]) ? c : b;
+        }
+    }
+
+
+    /// Median-of-3 for small partitions, Tukey's ninther for large ones.
+    template <typename T>
+    long select_pivot(const T* data, long istart, long iend)
+    {
+        long n = iend - istart + 1;
+        long mid = istart + n / 2;
+
+        if (n > quick_sort_ninther_threshold) {
+            long s = n / 8;
+            long a = median_of_three(data, istart, istart + s, istart + 2*s);
+            long b = median_of_three(data, mid - s, mid, mid + s);
+            long c = median_of_three(data, iend - 2*s, iend - s, iend);
+            return median_of_three(data, a, b, c);
+        }
+        return median_of_three(data, istart, mid, iend);
+    }
+
+
+    template <typename T>
+    void partition_three_way(T* data, long istart, long iend, long* lt, long* gt)
+    {
+        partition_three_way(data, istart, iend, select_pivot(data, istart, iend), lt, gt);
+    }
 
-        // Swap the pivot with the first element.
-        data[mid] = data[istart];
-        data[istart] = pivot;
 
-        // Partition.
-        i = istart + 1;
-        j = iend + 1;
-        while (i < j) {
-            if (data[i] <= pivot) {
+    /// Dijkstra's three-way partition around data[pivot]. On return, the elements in
+    /// [istart, lt) are less than the pivot, those in [lt, gt] are equal to the pivot, and
+    /// those in (gt, iend] are greater. The pivot stays at data[istart] until the end and is
+    /// compared in place, so it is never copied.
+    template <typename T>
+    void partition_three_way(T* data, long istart, long iend, long pivot, long* lt, long* gt)
+    {
+        std::swap(data[istart], data[pivot]);
+        const T& value = data[istart];
+
+        long l = istart + 1;
+        long i = istart + 1;
+        long g = iend;
+        while (i <= g) {
+            if (!(value <= data[i])) {
+                std::swap(data[l], data[i]);
+                l++;
                 i++;
+            } else if (!(data[i] <= value)) {
+                std::swap(data[i], data[g]);
+                g--;
             } else {
-                j--;
-                temp = data[i];
-                data[i] = data[j];
-                data[j] = temp;
+                i++;
             }
         }
-        data[istart] = data[j-1];
-        data[j-1] = pivot;
+        std::swap(data[istart], data[l-1]);
+        *lt = l - 1;
+        *gt = g;
+    }
+
+
+    /// Two-way partition around a single pivot. When the pivot equals the element before
+    /// the partition, which is no greater than any element in it, the keys equal to the pivot
+    /// are gathered on the left and set aside as a whole, so duplicates cannot cause
+    /// quadratic time.
+    /// \par References:
+    /// \li S. Edelkamp and A. Weiss. BlockQuicksort: Avoiding Branch Mispredictions in Quicksort.
+    ///     ESA 2016.
+    /// \li O. R. L. Peters. Pattern-defeating Quicksort. arXiv:2106.05123, 2021.
+    template <typename T>
+    void partition_block(T* data, long istart, long iend, bool has_predecessor, long* lt, long* gt)
+    {
+        std::swap(data[istart], data[select_pivot(data, istart, iend)]);
+
+        if (has_predecessor && data[istart] <= data[istart-1]) {
+            *lt = istart;
+            *gt = partition_block<true>(data, istart, iend);
+        } else {
+            long p = partition_block<false>(data, istart, iend);
+            *lt = p;
+            *gt = p;
+        }
+    }
+
 
-        // Recursively sort the two partitions.
-        if (istart < j-2) {
-            quick_sort(data, istart, j-2);
+    /// The pivot is at \b istart. Moves the elements less than the pivot, or not greater
+    /// when \b Equal, to its left and returns its final position.<br>
+    /// Each side scans a block and records the offsets of its misplaced elements without
+    /// branching on the comparisons, then the recorded pairs are swapped.
+    template <bool Equal, typename T>
+    long partition_block(T* data, long istart, long iend)
+    {
+        unsigned char offsets_l[quick_sort_block];
+        unsigned char offsets_r[quick_sort_block];
+        long start_l = 0, num_l = 0;
+        long start_r = 0, num_r = 0;
+
+        const T& pivot = data[istart];
+        long l = istart + 1;
+        long r = iend;
+
+        // [istart+1, l) goes left, (r, iend] goes right, [l, r] is unknown.
+        while (r - l + 1 > 2 * quick_sort_block) {
+            if (num_l == 0) {
+                start_l = 0;
+                for (long i = 0; i < quick_sort_block; i++) {
+                    offsets_l[num_l] = static_cast<unsigned char>(i);
+                    num_l += Equal ? !(data[l + i] <= pivot) : (pivot <= data[l + i]);
+                }
+            }
+            if (num_r == 0) {
+                start_r = 0;
+                for (long i = 0; i < quick_sort_block; i++) {
+                    offsets_r[num_r] = static_cast<unsigned char>(i);
+                    num_r += Equal ? (data[r - i] <= pivot) : !(pivot <= data[r - i]);
+                }
+            }
+
+            long num = std::min(num_l, num_r);
+            for (long j = 0; j < num; j++) {
+                std::swap(data[l + offsets_l[start_l + j]], data[r - offsets_r[start_r + j]]);
+            }
+            num_l -= num;
+            num_r -= num;
+            start_l += num;
+            start_r += num;
+            if (num_l == 0) {
+                l += quick_sort_block;
+            }
+            if (num_r == 0) {
+                r -= quick_sort_block;
+            }
         }
-        if (j < iend) {
-            quick_sort(data, j, iend);
+
+        // At most two blocks are left, partly processed or not: finish them one by one.
+        while (l <= r) {
+            if (Equal ? (data[l] <= pivot) : !(pivot <= data[l])) {
+                l++;
+            } else {
+                std::swap(data[l], data[r]);
+                r--;
+            }
         }
+
+        std::swap(data[istart], data[l-1]);
+        return l - 1;
     }
 } // namespace algorithm
 
@@ -0,0 +1,359 @@
+/*
+# Copyright (c) 2008 Chung Shin Yee <cshinyee@gmail.com>
+#
+#       http://github.com/xman
+#       http://myxman.org
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License as
+# published by the Free Software Foundation; either version 2 of the
+# License, or (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+# USA.
+#
+# The GNU General Public License is contained in the file COPYING.
+#
+*/
+
+#ifndef RADIXSORT_H
+#define RADIXSORT_H
+
+#include <cassert>
+#include <cstring>
+#include <algorithm>
+#include "insertionsort.h"
+
+namespace algorithm
+{
+    /// \brief Map a key to unsigned bits whose unsigned order is the order of the keys.
+    /// \param T The data type of the key, an integral or floating-point type.
+    template <typename T>
+    class RadixKey;
+
+    /// \brief Sort the \b length elements using the LSD Radix Sort algorithm.
+    /// \param T The data type of the elements, an integral or floating-point type.
+    /// \param[in,out] data The pointer to the list of elements.
+    /// \param[in] length The number of elements.
+    template <typename T>
+    void radix_sort(T* data, long length);
+
+    /// \brief Sort the \b length elements using the LSD Radix Sort algorithm with a caller-supplied buffer.
+    /// \param T The data type of the elements, an integral or floating-point type.
+    /// \param[in,out] data The pointer to the list of elements.
+    /// \param[in] length The number of elements.
+    /// \param[out] buffer The scratch space of at least \b length elements.
+    template <typename T>
+    void radix_sort(T* data, long length, T* buffer);
+
+    /// \brief Sort the \b length elements in place using the MSD Radix Sort algorithm.
+    /// \param T The data type of the elements, an integral or floating-point type.
+    /// \param[in,out] data The pointer to the list of elements.
+    /// \param[in] length The number of elements.
+    template <typename T>
+    void msd_radix_sort(T* data, long length);
+} // namespace algorithm
+
+
+// ===================================================================
+// Implementation
+// ===================================================================
+
+namespace algorithm
+{
+    /// The largest number of bits in the most significant digit of radix_sort(), whose
+    /// buckets are then sorted one at a time while they fit in the cache.
+    static const long radix_sort_top_bits = 12;
+
+    /// radix_sort() splits the elements on a top digit only if the buckets average at
+    /// least 2^radix_sort_bucket_bits elements.
+    static const long radix_sort_bucket_bits = 10;
+
+    /// The number of bits in a digit.
+    static const long radix_sort_bits = 8;
+
+    /// The number of distinct digits.
+    static const long radix_sort_radix = 1L << radix_sort_bits;
+
+    /// The MSD buckets with at most this number of elements are sorted by Insertion Sort.
+    static const long radix_sort_cutoff = 32;
+
+
+    /// Unsigned integers are their own keys.
+    template <typename U>
+    class RadixUnsignedKey
+    {
+    public:
+        typedef U Bits;
+        static Bits encode(U x) { return x; }
+    };
+
+    /// Flip the sign bit of signed integers so negative keys come first.
+    template <typename S, typename U>
+    class RadixSignedKey
+    {
+    public:
+        typedef U Bits;
+        static Bits encode(S x)
+        {
+            return static_cast<U>(x) ^ (U(1) << (sizeof(U)*8 - 1));
+        }
+    };
+
+    /// Flip all bits of negative IEEE 754 keys and the sign bit of the others.
+    /// \note -0.0 sorts before +0.0, and NaNs sort to the ends according to their sign.
+    template <typename F, typename U>
+    class RadixFloatKey
+    {
+    public:
+        typedef U Bits;
+        static Bits encode(F x)
+        {
+            U u;
+            std::memcpy(&u, &x, sizeof(u));
+            U sign = U(1) << (sizeof(U)*8 - 1);
+            return (u & sign) ? ~u : (u | sign);
+        }
+    };
+
+    template <> class RadixKey<unsigned char> : public RadixUnsignedKey<unsigned char> {};
+    template <> class RadixKey<unsigned short> : public RadixUnsignedKey<unsigned short> {};
+    template <> class RadixKey<unsigned int> : public RadixUnsignedKey<unsigned int> {};
+    template <> class RadixKey<unsigned long> : public RadixUnsignedKey<unsigned long> {};
+    template <> class RadixKey<unsigned long long> : public RadixUnsignedKey<unsigned long long> {};
+    template <> class RadixKey<signed char> : public RadixSignedKey<signed char, unsigned char> {};
+    template <> class RadixKey<short> : public RadixSignedKey<short, unsigned short> {};
+    template <> class RadixKey<int> : public RadixSignedKey<int, unsigned int> {};
+    template <> class RadixKey<long> : public RadixSignedKey<long, unsigned long> {};
+    template <> class RadixKey<long long> : public RadixSignedKey<long long, unsigned long long> {};
+    template <> class RadixKey<float> : public RadixFloatKey<float, unsigned int> {};
+    template <> class RadixKey<double> : public RadixFloatKey<double, unsigned long> {};
+
+
+    template <typename T>
+    static inline long radix_digit(const T& x, long digit);
+
+    template <typename T>
+    static T* radix_sort_lsd(T* data, T* buffer, long length, long bits);
+
+    template <typename T>
+    static void msd_radix_sort(T* data, long length, long digit);
+
+
+    template <typename T>
+    void radix_sort(T* data, long length)
+    {
+        assert(length > 0);
+
+        T* buffer = new T[length];
+        assert(buffer != NULL);
+
+        radix_sort(data, length, buffer);
+
+        delete[] buffer;
+    }
+
+
+    /// The keys are first distributed on a top digit of up to 12 bits, just below the highest
+    /// bit in which they differ. Every bucket is then small enough to be sorted by LSD passes
+    /// within the cache, instead of scattering the whole array once per digit.
+    /// \par References:
+    /// \li Introduction to Algorithms - T. H. Cormen, C. E. Leiserson, R. L. Rivest & C. Stein
+    /// \li P. M. Terdiman. Radix Sort Revisited. 2000.
+    /// \li O. Polychroniou and K. A. Ross. A Comprehensive Study of Main-Memory Partitioning and
+    ///     its Application to Large-Scale Comparison- and Radix-Sort. SIGMOD 2014.
+    template <typename T>
+    void radix_sort(T* data, long length, T* buffer)
+    {
+        typedef typename RadixKey<T>::Bits Bits;
+
+        assert(length > 0);
+        assert(buffer != NULL);
+
+        // Only the bits below the highest one in which two keys differ need sorting.
+        Bits first = RadixKey<T>::encode(data[0]);
+        Bits diff = 0;
+        for (long i = 1; i < length; i++) {
+            diff |= RadixKey<T>::encode(data[i]) ^ first;
+        }
+        long bits = 0;
+        for (; diff != 0; diff >>= 1) {
+            bits++;
+        }
+
+        long top = 0;
+        for (long m = length >> radix_sort_bucket_bits; m > 1 && top < radix_sort_top_bits; m >>= 1) {
+            top++;
+        }
+        top = std::min(top, bits);
+
+        if (top == 0) {
+            T* sorted = radix_sort_lsd(data, buffer, length, bits);
+            if (sorted != data) {
+                std::copy(sorted, sorted + length, data);
+            }
+            return;
+        }
+
+        const long shift = bits - top;
+        const long radix = 1L << top;
+        long* start = new long[radix + 1];
+        assert(start != NULL);
+        std::fill(start, start + radix + 1, 0L);
+
+        for (long i = 0; i < length; i++) {
+            start[((RadixKey<T>::encode(data[i]) >> shift) & (radix - 1)) + 1]++;
+        }
+        for (long b = 0; b < radix; b++) {
+            start[b + 1] += start[b];
+        }
+        for (long i = 0; i < length; i++) {
+            buffer[start[(RadixKey<T>::encode(data[i]) >> shift) & (radix - 1)]++] = data[i];
+        }
+
+        // The scatter advanced every start to the start of the next bucket.
+        long begin = 0;
+        for (long b = 0; b < radix; b++) {
+            long n = start[b] - begin;
+            if (n > 0) {
+                T* sorted = radix_sort_lsd(buffer + begin, data + begin, n, shift);
+                if (sorted != data + begin) {
+                    std::copy(sorted, sorted + n, data + begin);
+                }
+            }
+            begin = start[b];
+        }
+        delete[] start;
+    }
+
+
+    /// Sorts \b data on the \b bits lowest bits of the keys with \b buffer as scratch space, and
+    /// returns whichever of the two holds the result. One pass over the data counts every
+    /// digit. A digit that is the same for all the keys is skipped.
+    template <typename T>
+    T* radix_sort_lsd(T* data, T* buffer, long length, long bits)
+    {
+        const long ndigits = (bits + radix_sort_bits - 1) / radix_sort_bits;
+        long count[sizeof(typename RadixKey<T>::Bits) * 8 / radix_sort_bits * radix_sort_radix];
+
+        std::fill(count, count + ndigits * radix_sort_radix, 0L);
+        for (long i = 0; i < length; i++) {
+            for (long d = 0; d < ndigits; d++) {
+                count[d * radix_sort_radix + radix_digit(data[i], d)]++;
+            }
+        }
+
+        T* src = data;
+        T* dest = buffer;
+        for (long d = 0; d < ndigits; d++) {
+            long* offset = count + d * radix_sort_radix;
+            if (offset[radix_digit(src[0], d)] == length) {
+                continue;
+            }
+
+            long sum = 0;
+            for (long b = 0; b < radix_sort_radix; b++) {
+                long c = offset[b];
+                offset[b] = sum;
+                sum += c;
+            }
+            for (long i = 0; i < length; i++) {
+                dest[offset[radix_digit(src[i], d)]++] = src[i];
+            }
+            std::swap(src, dest);
+        }
+        return src;
+    }
+
+
+    template <typename T>
+    void msd_radix_sort(T* data, long length)
+    {
+        assert(length > 0);
+
+        msd_radix_sort(data, length, static_cast<long>(sizeof(typename RadixKey<T>::Bits) * 8 / radix_sort_bits) - 1);
+    }
+
+
+    /// American flag sort: the elements are permuted into their buckets in place, following
+    /// the cycles of misplaced elements, then every bucket is sorted on the next digit.
+    /// \par References:
+    /// P. M. McIlroy, K. Bostic and M. D. McIlroy. Engineering Radix Sort.
+    /// Computing Systems, 6(1), 1993.
+    template <typename T>
+    void msd_radix_sort(T* data, long length, long digit)
+    {
+        long count[radix_sort_radix];
+        long head[radix_sort_radix];
+        long tail[radix_sort_radix];
+
+        for (;;) {
+            if (length <= radix_sort_cutoff) {
+                if (length > 1) {
+                    insertion_sort(data, length);
+                }
+                return;
+            }
+
+            std::fill(count, count + radix_sort_radix, 0L);
+            for (long i = 0; i < length; i++) {
+                count[radix_digit(data[i], digit)]++;
+            }
+
+            // All keys share this digit: go straight to the next one.
+            if (count[radix_digit(data[0], digit)] == length) {
+                if (digit == 0) {
+                    return;
+                }
+                digit--;
+                continue;
+            }
+            break;
+        }
+
+        long sum = 0;
+        for (long b = 0; b < radix_sort_radix; b++) {
+            head[b] = sum;
+            sum += count[b];
+            tail[b] = sum;
+        }
+
+        for (long b = 0; b < radix_sort_radix; b++) {
+            while (head[b] < tail[b]) {
+                T x = data[head[b]];
+                long d = radix_digit(x, digit);
+                while (d != b) {
+                    std::swap(x, data[head[d]++]);
+                    d = radix_digit(x, digit);
+                }
+                data[head[b]++] = x;
+            }
+        }
+
+        if (digit > 0) {
+            long start = 0;
+            for (long b = 0; b < radix_sort_radix; b++) {
+                if (count[b] > 1) {
+                    msd_radix_sort(data + start, count[b], digit - 1);
+                }
+                start += count[b];
+            }
+        }
+    }
+
+
+    template <typename T>
+    inline long radix_digit(const T& x, long digit)
+    {
+        return static_cast<long>((RadixKey<T>::encode(x) >> (digit * radix_sort_bits)) & (radix_sort_radix - 1));
+    }
+} // namespace algorithm
+
+#endif // RADIXSORT_H
@@ -26,6 +26,9 @@
 #ifndef LINEARCONGRUENTIAL_H
 #define LINEARCONGRUENTIAL_H
 
+#include <cassert>
+#include <limits>
+
 namespace algorithm
 {
     template <typename T>
@@ -37,7 +40,9 @@ namespace algorithm
         /// \param[in] a The multiplier.
         /// \param[in] x0 The starting value.
         /// \param[in] c The increment.
-        /// \param[in] m The modulus.
+        /// \param[in] m The modulus, or 0 for the modulus 2^w of the w-bit type \b T.
+        /// \warning The modulus 0 relies on wrap-around and requires an unsigned \b T,
+        ///          as the overflow of a signed type is undefined.
         LinearCongruential(const T& a, const T& x0, const T& c, const T& m);
         ~LinearCongruential(void);
 
@@ -64,6 +69,7 @@ namespace algorithm
     LinearCongruential<T>::LinearCongruential(const T& a, const T& x0, const T& c, const T& m) :
         m_a(a), m_x(x0), m_c(c), m_m(m)
     {
+        assert(m != 0 || !std::numeric_limits<T>::is_signed);
     }
 
 
@@ -78,7 +84,10 @@ namespace algorithm
     template <typename T>
     const T& LinearCongruential<T>::next(void)
     {
-        m_x = (m_a * m_x + m_c) % m_m;
+        m_x = m_a * m_x + m_c;
+        if (m_m != 0) {
+            m_x = m_x % m_m;
+        }
         return m_x;
     }
 } // namespace algorithm
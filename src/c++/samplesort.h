@@ -0,0 +1,729 @@
+/*
+# Copyright (c) 2008 Chung Shin Yee <cshinyee@gmail.com>
+#
+#       http://github.com/xman
+#       http://myxman.org
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License as
+# published by the Free Software Foundation; either version 2 of the
+# License, or (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+# USA.
+#
+# The GNU General Public License is contained in the file COPYING.
+#
+*/
+
+#ifndef SAMPLESORT_H
+#define SAMPLESORT_H
+
+#include <cassert>
+#include <algorithm>
+#include <climits>
+#include <vector>
+#include <pthread.h>
+#include "forkjoin.h"
+#include "quicksort.h"
+#include "random/linearcongruential.h"
+
+namespace algorithm
+{
+    /// \brief Sort the \b length elements in place using the parallel Sample Sort algorithm
+    ///        on all online processors.
+    /// \param T The data type of the elements.
+    /// \param[in,out] data The pointer to the list of elements.
+    /// \param[in] length The number of elements.
+    template <typename T>
+    void sample_sort(T* data, long length);
+
+    /// \brief Sort the \b length elements in place using the parallel Sample Sort algorithm
+    ///        on the workers of \b pool.
+    /// \param T The data type of the elements.
+    /// \param[in,out] pool The thread pool to run on.
+    /// \param[in,out] data The pointer to the list of elements.
+    /// \param[in] length The number of elements.
+    /// \note The extra memory is O(threads * buckets * block), independent of \b length.
+    template <typename T>
+    void sample_sort(ForkJoinPool& pool, T* data, long length);
+} // namespace algorithm
+
+
+// ===================================================================
+// Implementation
+// ===================================================================
+
+namespace algorithm
+{
+    /// The subarrays with at most this number of elements are sorted by Quick Sort.
+    static const long sample_sort_cutoff = 1L << 16;
+
+    /// The maximum number of buckets per partitioning step is 2^sample_sort_log_buckets.
+    static const long sample_sort_log_buckets = 8;
+
+    /// The size of a block of elements moved as a unit, in bytes.
+    static const long sample_sort_block_bytes = 2048;
+
+    /// The recursion depth beyond which buckets are left to Quick Sort.
+    static const long sample_sort_max_depth = 8;
+
+    /// The multiplier and increment of the full-period 64-bit generator drawing the sample.
+    static const unsigned long sample_sort_random_a = 6364136223846793005UL;
+    static const unsigned long sample_sort_random_c = 1442695040888963407UL;
+
+
+    /// \brief The state of one in-place partitioning step of Sample Sort.<br>
+    ///        The array is cut into block-aligned stripes, one per thread. Every stripe is
+    ///        classified into per-bucket buffer blocks, and full blocks are written back to
+    ///        the front of the stripe. The full blocks are then permuted into their
+    ///        bucket, and the elements left in the buffers fill the remaining gaps.
+    template <typename T>
+    class SampleSortPartition
+    {
+    public:
+        SampleSortPartition(T* data, long length, long nstripes, unsigned long seed);
+        ~SampleSortPartition(void);
+
+        /// \brief Select the splitters from a random sample and build the search tree.
+        void sample(void);
+
+        /// \brief Classify stripe \b t into its buffers, writing full blocks back to the stripe.
+        void classify_stripe(long t);
+
+        /// \brief Compute the bucket boundaries from the counts of all stripes.
+        void compute_boundaries(void);
+
+        /// \brief Gather the full blocks at the front of the regions of the buckets of share \b t.
+        void move_empty_blocks(long t);
+
+        /// \brief Move full blocks into their buckets until none is left, as thread \b t.
+        void permute_blocks(long t);
+
+        /// \brief Save the elements of the buckets of share \b t spilled past their end.
+        void save_overflow(long t);
+
+        /// \brief Write the buffered and saved elements into the gaps of the buckets of share \b t.
+        void write_remainders(long t);
+
+        long nstripes(void) const;
+        long nbuckets(void) const;
+        long bucket_start(long i) const;
+        bool is_equal_bucket(long i) const;
+
+    private:
+        SampleSortPartition(const SampleSortPartition& rhs);
+        SampleSortPartition& operator=(const SampleSortPartition& rhs);
+
+        /// \brief Get the bucket of \b x.
+        long classify(const T& x) const;
+
+        /// \brief Is the block at \b pos full after classification?
+        bool is_full_block(long pos) const;
+
+        long round_up(long pos) const;
+        long stripe_begin(long t) const;
+        long stripe_end(long t) const;
+        long share_begin(long t) const;
+
+        T* m_data; ///< The elements to partition.
+        long m_length; ///< The number of elements.
+        long m_block; ///< The number of elements in a block.
+        long m_nstripes; ///< The number of stripes.
+        long m_stripe_blocks; ///< The number of blocks in every stripe but the last.
+        unsigned long m_seed; ///< The seed of the sampling.
+
+        long m_log_buckets; ///< The depth of the search tree.
+        long m_nsplitters; ///< The number of leaves of the search tree.
+        std::vector<T> m_tree; ///< The splitters in implicit binary search tree order.
+        std::vector<T> m_splitters; ///< The splitters in sorted order.
+        bool m_equal; ///< Are there equality buckets for duplicated splitters?
+        long m_nbuckets; ///< The number of buckets.
+
+        std::vector<T*> m_buffers; ///< The per-stripe buffer blocks, one per bucket.
+        std::vector<long> m_fill; ///< The number of elements in each buffer block.
+        std::vector<long> m_blocks; ///< The number of full blocks per stripe and bucket.
+        std::vector<long> m_written; ///< The number of full blocks written back per stripe.
+
+        std::vector<long> m_start; ///< The first index of each bucket.
+        std::vector<long> m_nfull; ///< The number of full blocks of each bucket.
+        std::vector<long> m_write; ///< The next block to write in each bucket.
+        std::vector<long> m_read; ///< The end of the unprocessed blocks in each bucket.
+        std::vector<long> m_written_end; ///< The end of the in-place blocks of each bucket.
+        std::vector<pthread_mutex_t> m_locks; ///< Guards m_write and m_read of each bucket.
+
+        T* m_swap; ///< Two swap blocks per stripe.
+        T* m_overflow; ///< The last block when it extends past the end of the array.
+        bool m_overflow_used; ///< Has m_overflow been written?
+        T* m_saved; ///< The elements spilled past the end of each bucket.
+        std::vector<long> m_nsaved; ///< The number of elements in m_saved per bucket.
+    };
+
+
+    /// \brief Run one phase of a SampleSortPartition for one stripe.
+    template <typename T>
+    class SampleSortStripeTask : public ForkJoinTask
+    {
+    public:
+        typedef void (SampleSortPartition<T>::*Phase)(long);
+
+        SampleSortStripeTask(SampleSortPartition<T>* partition, Phase phase, long t) :
+            m_partition(partition), m_phase(phase), m_t(t)
+        {
+        }
+
+        void compute(ForkJoinPool&)
+        {
+            (m_partition->*m_phase)(m_t);
+        }
+
+    private:
+        SampleSortPartition<T>* m_partition;
+        Phase m_phase;
+        long m_t;
+    };
+
+
+    /// \brief Sort a subarray: partition it into buckets, then sort the buckets concurrently.
+    template <typename T>
+    class SampleSortTask : public ForkJoinTask
+    {
+    public:
+        SampleSortTask(T* data, long length, long root_length, long depth) :
+            m_data(data), m_length(length), m_root_length(root_length), m_depth(depth)
+        {
+        }
+
+        void compute(ForkJoinPool& pool);
+
+    private:
+        T* m_data;
+        long m_length;
+        long m_root_length;
+        long m_depth;
+    };
+
+
+    static inline long sample_sort_random_index(LinearCongruential<unsigned long>& random, long n);
+
+    template <typename T>
+    static void run_sample_sort_phase(ForkJoinPool& pool, SampleSortPartition<T>& partition,
+                                      typename SampleSortStripeTask<T>::Phase phase, long nstripes);
+
+
+    template <typename T>
+    void sample_sort(T* data, long length)
+    {
+        assert(length > 0);
+
+        if (length <= sample_sort_cutoff) {
+            quick_sort(data, length);
+            return;
+        }
+
+        ForkJoinPool pool;
+        sample_sort(pool, data, length);
+    }
+
+
+    /// \par References:
+    /// \li P. Sanders and S. Winkel. Super Scalar Sample Sort. ESA 2004.
+    /// \li M. Axtmann, S. Witt, D. Ferizovic and P. Sanders. In-Place Parallel Super Scalar
+    ///     Samplesort (IPS4o). ESA 2017.
+    template <typename T>
+    void sample_sort(ForkJoinPool& pool, T* data, long length)
+    {
+        assert(length > 0);
+
+        SampleSortTask<T> task(data, length, length, 0);
+        pool.invoke(task);
+    }
+
+
+    template <typename T>
+    void SampleSortTask<T>::compute(ForkJoinPool& pool)
+    {
+        if (m_length <= sample_sort_cutoff || m_depth >= sample_sort_max_depth) {
+            quick_sort(m_data, m_length);
+            return;
+        }
+
+        // Give this subarray a share of the threads proportional to its size.
+        long nstripes = pool.nthreads() * (static_cast<double>(m_length) / m_root_length);
+        nstripes = std::max(1L, std::min(nstripes, pool.nthreads()));
+
+        std::vector<long> start;
+        std::vector<bool> equal;
+        {
+            typedef SampleSortPartition<T> Partition;
+            Partition partition(m_data, m_length, nstripes, m_length + m_depth);
+
+            partition.sample();
+            nstripes = partition.nstripes();
+            run_sample_sort_phase(pool, partition, &Partition::classify_stripe, nstripes);
+            partition.compute_boundaries();
+            run_sample_sort_phase(pool, partition, &Partition::move_empty_blocks, nstripes);
+            run_sample_sort_phase(pool, partition, &Partition::permute_blocks, nstripes);
+            run_sample_sort_phase(pool, partition, &Partition::save_overflow, nstripes);
+            run_sample_sort_phase(pool, partition, &Partition::write_remainders, nstripes);
+
+            for (long i = 0; i <= partition.nbuckets(); i++) {
+                start.push_back(partition.bucket_start(i));
+            }
+            for (long i = 0; i < partition.nbuckets(); i++) {
+                equal.push_back(partition.is_equal_bucket(i));
+            }
+        }
+
+        // Sort the large buckets as subtasks and the small ones right here.
+        std::vector<SampleSortTask<T> > subtasks;
+        subtasks.reserve(equal.size());
+        for (long i = 0; i < static_cast<long>(equal.size()); i++) {
+            long n = start[i+1] - start[i];
+            if (!equal[i] && n > sample_sort_cutoff) {
+                subtasks.push_back(SampleSortTask<T>(m_data + start[i], n, m_root_length, m_depth + 1));
+            }
+        }
+        for (long i = 0; i < static_cast<long>(subtasks.size()); i++) {
+            pool.fork(subtasks[i]);
+        }
+        for (long i = 0; i < static_cast<long>(equal.size()); i++) {
+            long n = start[i+1] - start[i];
+            if (!equal[i] && n > 1 && n <= sample_sort_cutoff) {
+                quick_sort(m_data + start[i], n);
+            }
+        }
+        for (long i = static_cast<long>(subtasks.size()) - 1; i >= 0; i--) {
+            pool.join(subtasks[i]);
+        }
+    }
+
+
+    template <typename T>
+    void run_sample_sort_phase(ForkJoinPool& pool, SampleSortPartition<T>& partition,
+                               typename SampleSortStripeTask<T>::Phase phase, long nstripes)
+    {
+        std::vector<SampleSortStripeTask<T> > tasks;
+        tasks.reserve(nstripes);
+        for (long t = 0; t < nstripes; t++) {
+            tasks.push_back(SampleSortStripeTask<T>(&partition, phase, t));
+        }
+        for (long t = 1; t < nstripes; t++) {
+            pool.fork(tasks[t]);
+        }
+        tasks[0].compute(pool);
+        for (long t = nstripes - 1; t >= 1; t--) {
+            pool.join(tasks[t]);
+        }
+    }
+
+
+    /// Draw a uniform index in [0, n). The high halves of two draws make one full word,
+    /// as the low bits of a power-of-two modulus generator are weak, and the word is
+    /// scaled to the range by a multiply-shift, the high word of the product.
+    inline long sample_sort_random_index(LinearCongruential<unsigned long>& random, long n)
+    {
+        const int half = sizeof(unsigned long) * CHAR_BIT / 2;
+        const unsigned long mask = (1UL << half) - 1;
+
+        unsigned long x1 = random.next() >> half;
+        unsigned long x0 = random.next() >> half;
+        unsigned long n1 = static_cast<unsigned long>(n) >> half;
+        unsigned long n0 = static_cast<unsigned long>(n) & mask;
+
+        unsigned long low = x1 * n0 + ((x0 * n0) >> half);
+        unsigned long middle = x0 * n1 + (low & mask);
+        return static_cast<long>(x1 * n1 + (low >> half) + (middle >> half));
+    }
+
+
+    template <typename T>
+    SampleSortPartition<T>::SampleSortPartition(T* data, long length, long nstripes, unsigned long seed) :
+        m_data(data), m_length(length), m_block(1), m_nstripes(nstripes), m_stripe_blocks(0),
+        m_seed(seed), m_log_buckets(sample_sort_log_buckets), m_nsplitters(0), m_tree(),
+        m_splitters(), m_equal(false), m_nbuckets(0), m_buffers(), m_fill(), m_blocks(),
+        m_written(), m_start(), m_nfull(), m_write(), m_read(), m_written_end(), m_locks(),
+        m_swap(NULL), m_overflow(NULL), m_overflow_used(false), m_saved(NULL), m_nsaved()
+    {
+        m_block = std::max(1L, sample_sort_block_bytes / static_cast<long>(sizeof(T)));
+
+        // Keep at least a few blocks per bucket.
+        while (m_log_buckets > 1 && (m_block << m_log_buckets) * 4 > m_length) {
+            m_log_buckets--;
+        }
+        m_nsplitters = 1L << m_log_buckets;
+
+        long nblocks = m_length / m_block;
+        m_nstripes = std::max(1L, std::min(m_nstripes, nblocks));
+        m_stripe_blocks = nblocks / m_nstripes;
+    }
+
+
+    template <typename T>
+    SampleSortPartition<T>::~SampleSortPartition(void)
+    {
+        for (long t = 0; t < static_cast<long>(m_buffers.size()); t++) {
+            delete[] m_buffers[t];
+        }
+        for (long i = 0; i < static_cast<long>(m_locks.size()); i++) {
+            pthread_mutex_destroy(&m_locks[i]);
+        }
+        delete[] m_swap;
+        delete[] m_overflow;
+        delete[] m_saved;
+    }
+
+
+    template <typename T>
+    void SampleSortPartition<T>::sample(void)
+    {
+        long k = m_nsplitters;
+
+        // Oversample by a factor of about 0.2 log2(n).
+        long log_length = 0;
+        for (long n = m_length; n > 1; n >>= 1) {
+            log_length++;
+        }
+        long alpha = std::max(1L, log_length / 5);
+        long nsample = std::min(m_length / 2, alpha * k);
+
+        // Move a random sample to the front of the array and sort it.
+        LinearCongruential<unsigned long> random(sample_sort_random_a, m_seed, sample_sort_random_c, 0UL);
+        for (long i = 0; i < nsample; i++) {
+            long j = i + sample_sort_random_index(random, m_length - i);
+            std::swap(m_data[i], m_data[j]);
+        }
+        quick_sort(m_data, nsample);
+
+        // Pick k-1 equidistant splitters, dropping duplicates.
+        for (long i = 1; i < k; i++) {
+            const T& s = m_data[i * nsample / k];
+            if (!m_splitters.empty() && !(m_splitters.back() < s)) {
+                m_equal = true;
+            } else {
+                m_splitters.push_back(s);
+            }
+        }
+        while (static_cast<long>(m_splitters.size()) < k - 1) {
+            m_splitters.push_back(m_splitters.back());
+        }
+        m_nbuckets = m_equal ? 2*k : k;
+
+        // Lay out the sorted splitters as an implicit search tree, root at index 1.
+        m_tree.resize(k, m_splitters[0]);
+        for (long level = 0; level < m_log_buckets; level++) {
+            long first = 1L << level;
+            long stride = k >> level;
+            for (long j = 0; j < first; j++) {
+                m_tree[first + j] = m_splitters[j * stride + stride/2 - 1];
+            }
+        }
+
+        // Allocate the per-stripe and per-bucket state.
+        long nb = m_nbuckets;
+        m_buffers.resize(m_nstripes, NULL);
+        for (long t = 0; t < m_nstripes; t++) {
+            m_buffers[t] = new T[nb * m_block];
+            assert(m_buffers[t] != NULL);
+        }
+        m_fill.resize(m_nstripes * nb, 0);
+        m_blocks.resize(m_nstripes * nb, 0);
+        m_written.resize(m_nstripes, 0);
+        m_start.resize(nb + 1, 0);
+        m_nfull.resize(nb, 0);
+        m_write.resize(nb, 0);
+        m_read.resize(nb, 0);
+        m_written_end.resize(nb, 0);
+        m_locks.resize(nb);
+        for (long i = 0; i < nb; i++) {
+            pthread_mutex_init(&m_locks[i], NULL);
+        }
+        m_swap = new T[2 * m_block * m_nstripes];
+        m_overflow = new T[m_block];
+        m_saved = new T[nb * m_block];
+        m_nsaved.resize(nb, 0);
+        assert(m_swap != NULL && m_overflow != NULL && m_saved != NULL);
+    }
+
+
+    /// Descend the search tree without branching on the comparisons. With equality
+    /// buckets, bucket 2i+1 holds the elements equal to splitter i.
+    template <typename T>
+    inline long SampleSortPartition<T>::classify(const T& x) const
+    {
+        long j = 1;
+        for (long level = 0; level < m_log_buckets; level++) {
+            j = 2*j + (m_tree[j] < x);
+        }
+        j -= m_nsplitters;
+
+        if (m_equal) {
+            j = 2*j + (j < m_nsplitters - 1 && !(x < m_splitters[j]));
+        }
+        return j;
+    }
+
+
+    template <typename T>
+    void SampleSortPartition<T>::classify_stripe(long t)
+    {
+        long nb = m_nbuckets;
+        long B = m_block;
+        T* buffer = m_buffers[t];
+        long* fill = &m_fill[t * nb];
+        long* blocks = &m_blocks[t * nb];
+        long write = stripe_begin(t);
+        long end = stripe_end(t);
+
+        // Writes never overtake reads, so full blocks can go back into the stripe.
+        for (long i = stripe_begin(t); i < end; i++) {
+            long b = classify(m_data[i]);
+            buffer[b*B + fill[b]] = m_data[i];
+            if (++fill[b] == B) {
+                std::copy(buffer + b*B, buffer + (b+1)*B, m_data + write);
+                write += B;
+                fill[b] = 0;
+                blocks[b]++;
+            }
+        }
+        m_written[t] = (write - stripe_begin(t)) / B;
+    }
+
+
+    /// The blocks of bucket i go to the block-aligned region starting at round_up(start[i]).
+    /// The last block of a bucket may spill into the unaligned head of the next bucket,
+    /// or past the end of the array into m_overflow.
+    template <typename T>
+    void SampleSortPartition<T>::compute_boundaries(void)
+    {
+        long nb = m_nbuckets;
+
+        m_start[0] = 0;
+        for (long i = 0; i < nb; i++) {
+            long size = 0;
+            long nfull = 0;
+            for (long t = 0; t < m_nstripes; t++) {
+                nfull += m_blocks[t*nb + i];
+                size += m_blocks[t*nb + i] * m_block + m_fill[t*nb + i];
+            }
+            m_start[i+1] = m_start[i] + size;
+            m_nfull[i] = nfull;
+            m_write[i] = round_up(m_start[i]);
+        }
+        assert(m_start[nb] == m_length);
+    }
+
+
+    template <typename T>
+    void SampleSortPartition<T>::move_empty_blocks(long t)
+    {
+        long B = m_block;
+        long last_slot = (m_length / B) * B;
+
+        for (long i = share_begin(t); i < share_begin(t+1); i++) {
+            long lo = round_up(m_start[i]);
+            long hi = std::min(round_up(m_start[i+1]), last_slot);
+            long left = lo;
+            long right = hi - B;
+
+            long nfull = 0;
+            for (long pos = lo; pos < hi; pos += B) {
+                nfull += is_full_block(pos);
+            }
+            m_read[i] = lo + nfull * B;
+
+            // Fill empty blocks from the front with full blocks from the back.
+            for (;;) {
+                while (left < hi && is_full_block(left)) {
+                    left += B;
+                }
+                while (right >= lo && !is_full_block(right)) {
+                    right -= B;
+                }
+                if (left >= right) {
+                    break;
+                }
+                std::copy(m_data + right, m_data + right + B, m_data + left);
+                left += B;
+                right -= B;
+            }
+        }
+    }
+
+
+    template <typename T>
+    void SampleSortPartition<T>::permute_blocks(long t)
+    {
+        long nb = m_nbuckets;
+        long B = m_block;
+        T* block = m_swap + 2*B*t;
+        T* other = block + B;
+
+        long b = share_begin(t);
+        for (long nempty = 0; nempty < nb; ) {
+            // Take an unprocessed block from bucket b.
+            pthread_mutex_lock(&m_locks[b]);
+            if (m_write[b] >= m_read[b]) {
+                pthread_mutex_unlock(&m_locks[b]);
+                b = (b + 1) % nb;
+                nempty++;
+                continue;
+            }
+            m_read[b] -= B;
+            std::copy(m_data + m_read[b], m_data + m_read[b] + B, block);
+            pthread_mutex_unlock(&m_locks[b]);
+            nempty = 0;
+
+            // Put it in place, carrying on with any unprocessed block it displaces.
+            for (;;) {
+                long c = classify(block[0]);
+
+                pthread_mutex_lock(&m_locks[c]);
+                long pos = m_write[c];
+                m_write[c] += B;
+                bool occupied = pos < m_read[c];
+                pthread_mutex_unlock(&m_locks[c]);
+
+                if (occupied) {
+                    std::copy(m_data + pos, m_data + pos + B, other);
+                    std::copy(block, block + B, m_data + pos);
+                    std::swap(block, other);
+                } else {
+                    if (pos + B > m_length) {
+                        std::copy(block, block + B, m_overflow);
+                        m_overflow_used = true;
+                    } else {
+                        std::copy(block, block + B, m_data + pos);
+                    }
+                    break;
+                }
+            }
+        }
+    }
+
+
+    template <typename T>
+    void SampleSortPartition<T>::save_overflow(long t)
+    {
+        long B = m_block;
+
+        for (long i = share_begin(t); i < share_begin(t+1); i++) {
+            long end = round_up(m_start[i]) + m_nfull[i] * B;
+            m_nsaved[i] = 0;
+            m_written_end[i] = end;
+
+            if (m_nfull[i] == 0) {
+                continue;
+            }
+            if (end > m_length) {
+                assert(m_overflow_used);
+                std::copy(m_overflow, m_overflow + B, m_saved + i*B);
+                m_nsaved[i] = B;
+                m_written_end[i] = end - B;
+            } else if (end > m_start[i+1]) {
+                std::copy(m_data + m_start[i+1], m_data + end, m_saved + i*B);
+                m_nsaved[i] = end - m_start[i+1];
+                m_written_end[i] = m_start[i+1];
+            }
+        }
+    }
+
+
+    template <typename T>
+    void SampleSortPartition<T>::write_remainders(long t)
+    {
+        long nb = m_nbuckets;
+        long B = m_block;
+
+        for (long i = share_begin(t); i < share_begin(t+1); i++) {
+            long skip = (m_nfull[i] > 0) ? round_up(m_start[i]) : -1;
+            long pos = m_start[i];
+
+            // Fill the unaligned head, then the tail after the blocks.
+            for (long s = -1; s < m_nstripes; s++) {
+                const T* src = (s < 0) ? m_saved + i*B : m_buffers[s] + i*B;
+                long n = (s < 0) ? m_nsaved[i] : m_fill[s*nb + i];
+                for (long k = 0; k < n; k++) {
+                    if (pos == skip) {
+                        pos = m_written_end[i];
+                    }
+                    m_data[pos++] = src[k];
+                }
+            }
+            assert(pos == m_start[i+1] || (pos == skip && m_written_end[i] == m_start[i+1]));
+        }
+    }
+
+
+    template <typename T>
+    inline long SampleSortPartition<T>::nstripes(void) const
+    {
+        return m_nstripes;
+    }
+
+
+    template <typename T>
+    inline long SampleSortPartition<T>::nbuckets(void) const
+    {
+        return m_nbuckets;
+    }
+
+
+    template <typename T>
+    inline long SampleSortPartition<T>::bucket_start(long i) const
+    {
+        return m_start[i];
+    }
+
+
+    template <typename T>
+    inline bool SampleSortPartition<T>::is_equal_bucket(long i) const
+    {
+        return m_equal && (i % 2 == 1);
+    }
+
+
+    template <typename T>
+    inline bool SampleSortPartition<T>::is_full_block(long pos) const
+    {
+        long t = std::min(pos / (m_stripe_blocks * m_block), m_nstripes - 1);
+        return pos < stripe_begin(t) + m_written[t] * m_block;
+    }
+
+
+    template <typename T>
+    inline long SampleSortPartition<T>::round_up(long pos) const
+    {
+        return (pos + m_block - 1) / m_block * m_block;
+    }
+
+
+    template <typename T>
+    inline long SampleSortPartition<T>::stripe_begin(long t) const
+    {
+        return t * m_stripe_blocks * m_block;
+    }
+
+
+    template <typename T>
+    inline long SampleSortPartition<T>::stripe_end(long t) const
+    {
+        return (t == m_nstripes - 1) ? m_length : stripe_begin(t+1);
+    }
+
+
+    template <typename T>
+    inline long SampleSortPartition<T>::share_begin(long t) const
+    {
+        return t * m_nbuckets / m_nstripes;
+    }
+} // namespace algorithm
+
+#endif // SAMPLESORT_H
@@ -0,0 +1,294 @@
+/*
+# Copyright (c) 2008 Chung Shin Yee <cshinyee@gmail.com>
+#
+#       http://github.com/xman
+#       http://myxman.org
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License as
+# published by the Free Software Foundation; either version 2 of the
+# License, or (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+# USA.
+#
+# The GNU General Public License is contained in the file COPYING.
+#
+*/
+
+#ifndef SELECTION_H
+#define SELECTION_H
+
+#include <cassert>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+#include "insertionsort.h"
+#include "heapsort.h"
+#include "quicksort.h"
+
+namespace algorithm
+{
+    /// \brief Rearrange the \b length elements so that data[k] is the element that would be
+    ///        there if they were sorted, with no greater element before it and no smaller one
+    ///        after it.
+    /// \param T The data type of the elements.
+    /// \param[in,out] data The pointer to the list of elements.
+    /// \param[in] length The number of elements.
+    /// \param[in] k The rank to select, from 0.
+    /// \return The k-th smallest element.
+    template <typename T>
+    T intro_select(T* data, long length, long k);
+
+    /// \brief Rearrange the elements from \b istart to \b iend so that data[k] is the
+    ///        element that would be there if they were sorted.
+    /// \param T The data type of the elements.
+    /// \param[in,out] data The pointer to the list of elements.
+    /// \param[in] istart The index of the first elements.
+    /// \param[in] iend The index of the last elements.
+    /// \param[in] k The index to select, between \b istart and \b iend.
+    /// \return The selected element.
+    template <typename T>
+    T intro_select(T* data, long istart, long iend, long k);
+
+    /// \brief Move the \b k smallest of the \b length elements to the front, in sorted order.
+    /// \param T The data type of the elements.
+    /// \param[in,out] data The pointer to the list of elements.
+    /// \param[in] length The number of elements.
+    /// \param[in] k The number of smallest elements to sort.
+    template <typename T>
+    void partial_sort(T* data, long length, long k);
+
+
+    /// \brief The \b k smallest elements of a stream, kept in a bounded max-heap.<br>
+    ///        Each element costs O(1) when it's not among the k smallest so far, O(log k)
+    ///        otherwise.
+    template <typename T>
+    class TopK
+    {
+    public:
+        /// \brief Construct an empty selection of at most \b k elements.
+        explicit TopK(long k);
+
+        /// \brief Offer an element from the stream.
+        void push(const T& x);
+
+        /// \brief Get the number of elements kept, min(k, number of elements pushed).
+        long size(void) const;
+
+        /// \brief Get the largest element kept, the one the next smaller element replaces.
+        /// \warning It's an error to call top() when no element is kept.
+        const T& top(void) const;
+
+        /// \brief Copy the elements kept to \b out in ascending order.
+        /// \param[out] out The pointer to at least size() elements.
+        void sorted(T* out) const;
+
+    private:
+        long m_k; ///< The maximum number of elements kept.
+        std::vector<T> m_heap; ///< The elements kept, as a max-heap.
+    };
+} // namespace algorithm
+
+
+// ===================================================================
+// Implementation
+// ===================================================================
+
+namespace algorithm
+{
+    /// Ranges up to this size are finished by Insertion Sort.
+    static const long intro_select_cutoff = 16;
+
+    /// Ranges above this size pick their pivot by Floyd-Rivest sampling.
+    static const long intro_select_floyd_rivest = 600;
+
+
+    template <typename T>
+    static void intro_select_loop(T* data, long istart, long iend, long k, bool guaranteed);
+
+    template <typename T>
+    static long median_of_medians(T* data, long istart, long iend);
+
+
+    template <typename T>
+    T intro_select(T* data, long length, long k)
+    {
+        assert(length > 0);
+
+        return intro_select(data, 0, length-1, k);
+    }
+
+
+    template <typename T>
+    T intro_select(T* data, long istart, long iend, long k)
+    {
+        assert(iend - istart + 1 > 0);
+        assert(k >= istart && k <= iend);
+
+        intro_select_loop(data, istart, iend, k, false);
+        return data[k];
+    }
+
+
+    /// Each step partitions three ways and keeps the side holding \b k, stopping early when
+    /// k lands among the keys equal to the pivot. Large ranges take the pivot from a
+    /// recursive selection on a subrange sized and placed around the relative rank of k,
+    /// so a single partition usually leaves only a few elements around k. When two steps in
+    /// a row fail to halve the range, or from the start when \b guaranteed, the pivot is the
+    /// median of medians from then on. The ranges thus shrink geometrically, each step costs
+    /// time linear in its range, and the time is O(n) whatever the input.
+    /// \par References:
+    /// \li R. W. Floyd and R. L. Rivest. Algorithm 489: The Algorithm SELECT. CACM 18(3), 1975.
+    /// \li M. Blum, R. W. Floyd, V. Pratt, R. L. Rivest and R. E. Tarjan. Time Bounds for
+    ///     Selection. JCSS 7(4), 1973.
+    /// \li D. R. Musser. Introspective Sorting and Selection Algorithms. SP&E 27(8), 1997.
+    template <typename T>
+    void intro_select_loop(T* data, long istart, long iend, long k, bool guaranteed)
+    {
+        long lt, gt;
+        long checkpoint = iend - istart + 1;
+        long steps = 0;
+
+        while (iend - istart + 1 > intro_select_cutoff) {
+            long n = iend - istart + 1;
+            long pivot;
+
+            if (!guaranteed && steps == 2) {
+                guaranteed = (2 * n > checkpoint);
+                checkpoint = n;
+                steps = 0;
+            }
+            steps++;
+
+            if (guaranteed) {
+                pivot = median_of_medians(data, istart, iend);
+            } else if (n > intro_select_floyd_rivest) {
+                double z = std::log(static_cast<double>(n));
+                double s = 0.5 * std::exp(2.0 * z / 3.0);
+                double i = static_cast<double>(k - istart + 1);
+                double sd = 0.5 * std::sqrt(z * s * (n - s) / n) * (2*i < n ? -1.0 : 1.0);
+                long left = std::max(istart, static_cast<long>(k - i * s / n + sd));
+                long right = std::min(iend, static_cast<long>(k + (n - i) * s / n + sd));
+                intro_select_loop(data, left, right, k, false);
+                pivot = k;
+            } else {
+                pivot = select_pivot(data, istart, iend);
+            }
+
+            partition_three_way(data, istart, iend, pivot, &lt, &gt);
+            if (k < lt) {
+                iend = lt - 1;
+            } else if (k > gt) {
+                istart = gt + 1;
+            } else {
+                return;
+            }
+        }
+        insertion_sort(data, istart, iend);
+    }
+
+
+    /// Sort groups of 5, gather their medians at the front, and select the median of those
+    /// with the same guarantee. At least 3/10 of the range lies on either side of it.
+    template <typename T>
+    long median_of_medians(T* data, long istart, long iend)
+    {
+        long nmedians = 0;
+
+        for (long i = istart; i <= iend; i += 5) {
+            long last = std::min(i + 4, iend);
+            insertion_sort(data, i, last);
+            std::swap(data[istart + nmedians], data[i + (last - i) / 2]);
+            nmedians++;
+        }
+
+        long mid = istart + (nmedians - 1) / 2;
+        intro_select_loop(data, istart, istart + nmedians - 1, mid, true);
+        return mid;
+    }
+
+
+    template <typename T>
+    void partial_sort(T* data, long length, long k)
+    {
+        assert(length > 0);
+        assert(k >= 0 && k <= length);
+
+        if (k == 0) {
+            return;
+        }
+        if (k < length) {
+            intro_select(data, 0, length-1, k-1);
+        }
+        quick_sort(data, 0, k-1);
+    }
+
+
+    template <typename T>
+    TopK<T>::TopK(long k)
+        : m_k(k)
+    {
+        assert(k > 0);
+
+        m_heap.reserve(k);
+    }
+
+
+    template <typename T>
+    void TopK<T>::push(const T& x)
+    {
+        if (static_cast<long>(m_heap.size()) < m_k) {
+            // Sift the new leaf up.
+            m_heap.push_back(x);
+            long child = static_cast<long>(m_heap.size()) - 1;
+            while (child > 0) {
+                long parent = (child - 1) / 2;
+                if (!(m_heap[parent] < m_heap[child])) {
+                    break;
+                }
+                std::swap(m_heap[parent], m_heap[child]);
+                child = parent;
+            }
+        } else if (x < m_heap[0]) {
+            m_heap[0] = x;
+            sift_down(&m_heap[0], 0L, m_k);
+        }
+    }
+
+
+    template <typename T>
+    long TopK<T>::size(void) const
+    {
+        return static_cast<long>(m_heap.size());
+    }
+
+
+    template <typename T>
+    const T& TopK<T>::top(void) const
+    {
+        assert(!m_heap.empty());
+
+        return m_heap[0];
+    }
+
+
+    template <typename T>
+    void TopK<T>::sorted(T* out) const
+    {
+        if (m_heap.empty()) {
+            return;
+        }
+        std::copy(m_heap.begin(), m_heap.end(), out);
+        heap_sort(out, size());
+    }
+} // namespace algorithm
+
+#endif // SELECTION_H
@@ -0,0 +1,529 @@
+/*
+# Copyright (c) 2008 Chung Shin Yee <cshinyee@gmail.com>
+#
+#       http://github.com/xman
+#       http://myxman.org
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License as
+# published by the Free Software Foundation; either version 2 of the
+# License, or (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+# USA.
+#
+# The GNU General Public License is contained in the file COPYING.
+#
+*/
+
+// Set operations on sorted arrays of distinct elements, such as posting lists. The int and
+// long overloads compare blocks of elements on AVX2 registers when the CPU has it, and every
+// operation gallops through the larger input when the sizes are far apart.
+
+#ifndef SETOPS_H
+#define SETOPS_H
+
+#include <cassert>
+#include <algorithm>
+#include <vector>
+#include "timsort.h"
+#include "losertree.h"
+#include "sortnetwork.h"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define ALGORITHM_SETOPS_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace algorithm
+{
+    /// \brief Intersect two sorted sets.
+    /// \param T The data type of the elements.
+    /// \param[in] a The first set, sorted and without duplicates.
+    /// \param[in] na The number of elements in \b a.
+    /// \param[in] b The second set, sorted and without duplicates.
+    /// \param[in] nb The number of elements in \b b.
+    /// \param[out] out The output of at least min(\b na, \b nb) elements, which may be \b a.
+    /// \return The number of elements written to \b out.
+    template <typename T>
+    long sorted_intersection(const T* a, long na, const T* b, long nb, T* out);
+
+    /// \brief Unite two sorted sets.
+    /// \param T The data type of the elements.
+    /// \param[in] a The first set, sorted and without duplicates.
+    /// \param[in] na The number of elements in \b a.
+    /// \param[in] b The second set, sorted and without duplicates.
+    /// \param[in] nb The number of elements in \b b.
+    /// \param[out] out The output of at least \b na + \b nb elements.
+    /// \return The number of elements written to \b out.
+    template <typename T>
+    long sorted_union(const T* a, long na, const T* b, long nb, T* out);
+
+    /// \brief Subtract a sorted set from another.
+    /// \param T The data type of the elements.
+    /// \param[in] a The set to subtract from, sorted and without duplicates.
+    /// \param[in] na The number of elements in \b a.
+    /// \param[in] b The set to subtract, sorted and without duplicates.
+    /// \param[in] nb The number of elements in \b b.
+    /// \param[out] out The output of at least \b na elements, which may be \b a.
+    /// \return The number of elements of \b a not in \b b written to \b out.
+    template <typename T>
+    long sorted_difference(const T* a, long na, const T* b, long nb, T* out);
+
+    /// \brief Intersect \b k sorted sets, smallest first.
+    /// \param T The data type of the elements.
+    /// \param[in] sets The sets, sorted and without duplicates.
+    /// \param[in] lengths The number of elements in each set.
+    /// \param[in] k The number of sets.
+    /// \param[out] out The output of at least as many elements as the smallest set.
+    /// \return The number of elements written to \b out.
+    template <typename T>
+    long sorted_intersection(const T* const* sets, const long* lengths, long k, T* out);
+
+    /// \brief Unite \b k sorted sets with a tournament tree.
+    /// \param T The data type of the elements.
+    /// \param[in] sets The sets, sorted and without duplicates.
+    /// \param[in] lengths The number of elements in each set.
+    /// \param[in] k The number of sets.
+    /// \param[out] out The output of at least as many elements as all the sets.
+    /// \return The number of elements written to \b out.
+    /// \note Only the O(k) state of the tournament tree is allocated.
+    template <typename T>
+    long sorted_union(const T* const* sets, const long* lengths, long k, T* out);
+
+    long sorted_intersection(const int* a, long na, const int* b, long nb, int* out);
+    long sorted_intersection(const long* a, long na, const long* b, long nb, long* out);
+    long sorted_union(const int* a, long na, const int* b, long nb, int* out);
+    long sorted_union(const long* a, long na, const long* b, long nb, long* out);
+    long sorted_difference(const int* a, long na, const int* b, long nb, int* out);
+    long sorted_difference(const long* a, long na, const long* b, long nb, long* out);
+} // namespace algorithm
+
+
+// ===================================================================
+// Implementation
+// ===================================================================
+
+namespace algorithm
+{
+    /// The inputs are searched by galloping when one is this many times larger than the other.
+    static const long set_ops_gallop_ratio = 32;
+
+
+    static bool set_ops_skewed(long na, long nb);
+
+    template <typename T>
+    static long set_ops_unique(T* data, long length);
+
+
+    inline bool set_ops_skewed(long na, long nb)
+    {
+        return na > set_ops_gallop_ratio * nb || nb > set_ops_gallop_ratio * na;
+    }
+
+
+    /// Each element of the smaller set is searched by galloping from the position of the
+    /// previous one, so the time is O(m log(n/m)) for sets of m <= n elements.
+    /// \par References:
+    /// \li E. D. Demaine, A. Lopez-Ortiz and J. I. Munro. Adaptive Set Intersections, Unions,
+    ///     and Differences. SODA 2000.
+    template <typename T>
+    long sorted_intersection(const T* a, long na, const T* b, long nb, T* out)
+    {
+        long i = 0;
+        long j = 0;
+        long k = 0;
+
+        if (set_ops_skewed(na, nb)) {
+            if (na > nb) {
+                std::swap(a, b);
+                std::swap(na, nb);
+            }
+            for (; i < na && j < nb; i++) {
+                j += gallop_left(a[i], b + j, nb - j, 0L);
+                if (j < nb && !(a[i] < b[j])) {
+                    out[k++] = a[i];
+                    j++;
+                }
+            }
+            return k;
+        }
+
+        while (i < na && j < nb) {
+            if (a[i] < b[j]) {
+                i++;
+            } else if (b[j] < a[i]) {
+                j++;
+            } else {
+                out[k++] = a[i];
+                i++;
+                j++;
+            }
+        }
+        return k;
+    }
+
+
+    template <typename T>
+    long sorted_union(const T* a, long na, const T* b, long nb, T* out)
+    {
+        long i = 0;
+        long j = 0;
+        long k = 0;
+
+        if (set_ops_skewed(na, nb)) {
+            if (na > nb) {
+                std::swap(a, b);
+                std::swap(na, nb);
+            }
+            // Copy the stretches of b between the elements of a.
+            for (; i < na; i++) {
+                long g = j + gallop_left(a[i], b + j, nb - j, 0L);
+                k = std::copy(b + j, b + g, out + k) - out;
+                out[k++] = a[i];
+                j = (g < nb && !(a[i] < b[g])) ? g + 1 : g;
+            }
+            return std::copy(b + j, b + nb, out + k) - out;
+        }
+
+        while (i < na && j < nb) {
+            if (a[i] < b[j]) {
+                out[k++] = a[i++];
+            } else if (b[j] < a[i]) {
+                out[k++] = b[j++];
+            } else {
+                out[k++] = a[i];
+                i++;
+                j++;
+            }
+        }
+        k = std::copy(a + i, a + na, out + k) - out;
+        return std::copy(b + j, b + nb, out + k) - out;
+    }
+
+
+    template <typename T>
+    long sorted_difference(const T* a, long na, const T* b, long nb, T* out)
+    {
+        long i = 0;
+        long j = 0;
+        long k = 0;
+
+        if (nb > set_ops_gallop_ratio * na) {
+            // Look every element of a up in b.
+            for (; i < na; i++) {
+                j += gallop_left(a[i], b + j, nb - j, 0L);
+                if (j == nb || a[i] < b[j]) {
+                    out[k++] = a[i];
+                }
+            }
+            return k;
+        }
+        if (na > set_ops_gallop_ratio * nb) {
+            // Copy the stretches of a between the elements of b.
+            for (; j < nb && i < na; j++) {
+                long g = i + gallop_left(b[j], a + i, na - i, 0L);
+                k = std::copy(a + i, a + g, out + k) - out;
+                i = (g < na && !(b[j] < a[g])) ? g + 1 : g;
+            }
+            return std::copy(a + i, a + na, out + k) - out;
+        }
+
+        while (i < na && j < nb) {
+            if (a[i] < b[j]) {
+                out[k++] = a[i++];
+            } else if (b[j] < a[i]) {
+                j++;
+            } else {
+                i++;
+                j++;
+            }
+        }
+        return std::copy(a + i, a + na, out + k) - out;
+    }
+
+
+    /// The smallest set is intersected with the next smallest into \b out, then \b out with
+    /// each larger set in place, so the intermediate result only shrinks.
+    template <typename T>
+    long sorted_intersection(const T* const* sets, const long* lengths, long k, T* out)
+    {
+        assert(k > 0);
+
+        // Visit the sets by increasing (length, index) without sorting them.
+        long current = 0;
+        for (long i = 1; i < k; i++) {
+            if (lengths[i] < lengths[current]) {
+                current = i;
+            }
+        }
+        long n = std::copy(sets[current], sets[current] + lengths[current], out) - out;
+
+        for (long visited = 1; visited < k && n > 0; visited++) {
+            long next = -1;
+            for (long i = 0; i < k; i++) {
+                bool after = lengths[i] > lengths[current] || (lengths[i] == lengths[current] && i > current);
+                if (after && (next < 0 || lengths[i] < lengths[next])) {
+                    next = i;
+                }
+            }
+            n = sorted_intersection(static_cast<const T*>(out), n, sets[next], lengths[next], out);
+            current = next;
+        }
+        return n;
+    }
+
+
+    template <typename T>
+    long sorted_union(const T* const* sets, const long* lengths, long k, T* out)
+    {
+        assert(k > 0);
+
+        if (k == 1) {
+            return std::copy(sets[0], sets[0] + lengths[0], out) - out;
+        }
+        if (k == 2) {
+            return sorted_union(sets[0], lengths[0], sets[1], lengths[1], out);
+        }
+
+        LoserTree<T> tree(k);
+        std::vector<long> next(k, 1);
+        for (long i = 0; i < k; i++) {
+            if (lengths[i] > 0) {
+                tree.set(i, sets[i][0]);
+            }
+        }
+        tree.build();
+
+        long n = 0;
+        while (!tree.empty()) {
+            long s = tree.winner();
+            if (n == 0 || out[n-1] < tree.top()) {
+                out[n++] = tree.top();
+            }
+            if (next[s] < lengths[s]) {
+                tree.replace_top(sets[s][next[s]++]);
+            } else {
+                tree.pop();
+            }
+        }
+        return n;
+    }
+
+
+    /// Remove the adjacent duplicates without branching on the comparisons.
+    template <typename T>
+    long set_ops_unique(T* data, long length)
+    {
+        if (length == 0) {
+            return 0;
+        }
+        long k = 1;
+        for (long i = 1; i < length; i++) {
+            T x = data[i];
+            data[k] = x;
+            k += (data[k-1] < x);
+        }
+        return k;
+    }
+
+
+#ifdef ALGORITHM_SETOPS_AVX2
+
+#define ALGORITHM_AVX2 __attribute__((target("avx2"), always_inline))
+
+    /// \brief The all-pairs comparison of two AVX2 registers of T.
+    template <typename T>
+    class SetOpsLanes;
+
+    template <>
+    class SetOpsLanes<int>
+    {
+    public:
+        enum { width = 8 };
+
+        /// \brief Get the bit mask of the elements of \b a found among the elements of \b b.
+        static inline ALGORITHM_AVX2 unsigned match(const int* a, const int* b)
+        {
+            const __m256i rotate = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 0);
+            __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a));
+            __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b));
+            __m256i eq = _mm256_cmpeq_epi32(va, vb);
+            for (int r = 1; r < width; r++) {
+                vb = _mm256_permutevar8x32_epi32(vb, rotate);
+                eq = _mm256_or_si256(eq, _mm256_cmpeq_epi32(va, vb));
+            }
+            return static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(eq)));
+        }
+    };
+
+    template <>
+    class SetOpsLanes<long>
+    {
+    public:
+        enum { width = 4 };
+
+        static inline ALGORITHM_AVX2 unsigned match(const long* a, const long* b)
+        {
+            __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a));
+            __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b));
+            __m256i eq = _mm256_cmpeq_epi64(va, vb);
+            for (int r = 1; r < width; r++) {
+                vb = _mm256_permute4x64_epi64(vb, _MM_SHUFFLE(0, 3, 2, 1));
+                eq = _mm256_or_si256(eq, _mm256_cmpeq_epi64(va, vb));
+            }
+            return static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(eq)));
+        }
+    };
+
+#undef ALGORITHM_AVX2
+
+
+    /// Blocks of a and b are compared all against all on registers. The matches of the
+    /// current block of a accumulate until the block is retired, when the one of the two
+    /// blocks ending lower advances, and then the matched (intersection) or unmatched
+    /// (difference) elements are written out. Since a block of b is retired only below the
+    /// current block of a, the tails can be finished by the scalar two-pointer loop.
+    /// \par References:
+    /// \li B. Schlegel, T. Willhalm and W. Lehner. Fast Sorted-Set Intersection using SIMD
+    ///     Instructions. ADMS 2011.
+    /// \li D. Lemire, L. Boytsov and N. Kurz. SIMD Compression and the Intersection of Sorted
+    ///     Integers. SP&E 46(6), 2016.
+    template <bool Intersect, typename T>
+    static __attribute__((target("avx2"))) long set_ops_avx2(const T* a, long na, const T* b, long nb, T* out)
+    {
+        const long w = SetOpsLanes<T>::width;
+        long i = 0;
+        long j = 0;
+        long k = 0;
+        unsigned matched = 0;
+
+        while (i + w <= na && j + w <= nb) {
+            matched |= SetOpsLanes<T>::match(a + i, b + j);
+            T amax = a[i + w - 1];
+            T bmax = b[j + w - 1];
+            if (amax <= bmax) {
+                unsigned emit = Intersect ? matched : (~matched & ((1u << w) - 1));
+                while (emit != 0) {
+                    out[k++] = a[i + __builtin_ctz(emit)];
+                    emit &= emit - 1;
+                }
+                i += w;
+                matched = 0;
+            }
+            if (bmax <= amax) {
+                j += w;
+            }
+        }
+
+        // The current block of a may have matched retired blocks of b already.
+        long block = i;
+        for (; i < na; i++) {
+            bool found;
+            if (i < block + w && ((matched >> (i - block)) & 1)) {
+                found = true;
+            } else {
+                while (j < nb && b[j] < a[i]) {
+                    j++;
+                }
+                found = (j < nb && b[j] == a[i]);
+            }
+            if (found == Intersect) {
+                out[k++] = a[i];
+            }
+        }
+        return k;
+    }
+
+
+    inline long sorted_intersection(const int* a, long na, const int* b, long nb, int* out)
+    {
+        if (!set_ops_skewed(na, nb) && __builtin_cpu_supports("avx2")) {
+            return set_ops_avx2<true>(a, na, b, nb, out);
+        }
+        return sorted_intersection<int>(a, na, b, nb, out);
+    }
+
+
+    inline long sorted_intersection(const long* a, long na, const long* b, long nb, long* out)
+    {
+        if (!set_ops_skewed(na, nb) && __builtin_cpu_supports("avx2")) {
+            return set_ops_avx2<true>(a, na, b, nb, out);
+        }
+        return sorted_intersection<long>(a, na, b, nb, out);
+    }
+
+
+    inline long sorted_difference(const int* a, long na, const int* b, long nb, int* out)
+    {
+        if (!set_ops_skewed(na, nb) && __builtin_cpu_supports("avx2")) {
+            return set_ops_avx2<false>(a, na, b, nb, out);
+        }
+        return sorted_difference<int>(a, na, b, nb, out);
+    }
+
+
+    inline long sorted_difference(const long* a, long na, const long* b, long nb, long* out)
+    {
+        if (!set_ops_skewed(na, nb) && __builtin_cpu_supports("avx2")) {
+            return set_ops_avx2<false>(a, na, b, nb, out);
+        }
+        return sorted_difference<long>(a, na, b, nb, out);
+    }
+
+#else
+
+    inline long sorted_intersection(const int* a, long na, const int* b, long nb, int* out)
+    {
+        return sorted_intersection<int>(a, na, b, nb, out);
+    }
+
+
+    inline long sorted_intersection(const long* a, long na, const long* b, long nb, long* out)
+    {
+        return sorted_intersection<long>(a, na, b, nb, out);
+    }
+
+
+    inline long sorted_difference(const int* a, long na, const int* b, long nb, int* out)
+    {
+        return sorted_difference<int>(a, na, b, nb, out);
+    }
+
+
+    inline long sorted_difference(const long* a, long na, const long* b, long nb, long* out)
+    {
+        return sorted_difference<long>(a, na, b, nb, out);
+    }
+
+#endif // ALGORITHM_SETOPS_AVX2
+
+
+    /// The union is the merging network of sortnetwork.h followed by the removal of the
+    /// elements found in both sets.
+    inline long sorted_union(const int* a, long na, const int* b, long nb, int* out)
+    {
+        if (!set_ops_skewed(na, nb) && network_merge(a, na, b, nb, out)) {
+            return set_ops_unique(out, na + nb);
+        }
+        return sorted_union<int>(a, na, b, nb, out);
+    }
+
+
+    inline long sorted_union(const long* a, long na, const long* b, long nb, long* out)
+    {
+        if (!set_ops_skewed(na, nb) && network_merge(a, na, b, nb, out)) {
+            return set_ops_unique(out, na + nb);
+        }
+        return sorted_union<long>(a, na, b, nb, out);
+    }
+} // namespace algorithm
+
+#endif // SETOPS_H
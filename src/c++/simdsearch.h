@@ -0,0 +1,206 @@
+/*
+# Copyright (c) 2008 Chung Shin Yee <cshinyee@gmail.com>
+#
+#       http://github.com/xman
+#       http://myxman.org
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License as
+# published by the Free Software Foundation; either version 2 of the
+# License, or (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+# USA.
+#
+# The GNU General Public License is contained in the file COPYING.
+#
+*/
+
+// Substring search filtering the candidate positions on SIMD registers, in front of the
+// KMP automaton of kmp.h. The AVX2 filter is compiled whatever the compiler flags and used
+// only when the CPU reports AVX2 at run time; SSE2 is part of x86-64.
+
+#ifndef SIMDSEARCH_H
+#define SIMDSEARCH_H
+
+#include <cassert>
+#include <cstring>
+#include "kmp.h"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define ALGORITHM_SIMDSEARCH_X86 1
+#include <immintrin.h>
+#endif
+
+namespace algorithm
+{
+    /// \brief Scan the text string for the first occurrence of the pattern string, comparing
+    ///        16 or 32 positions at a time and falling back to KMP on periodic inputs.
+    /// \param[in] pattern The pattern string.
+    /// \param[in] text The text string, which may contain NUL bytes.
+    /// \param[in] length The length of the pattern string.
+    /// \param[in] text_length The length of the text string.
+    /// \param[in] failure_link The failure links set up by kmp_setup().
+    /// \return The index in \b text where a copy of \b pattern begins.
+    /// \return -1 if no match for \b pattern is found.
+    long simd_scan(const char* pattern, const char* text, long length, long text_length,
+                   const long* failure_link);
+} // namespace algorithm
+
+
+// ===================================================================
+// Implementation
+// ===================================================================
+
+namespace algorithm
+{
+    /// The filter hands over to KMP once the bytes compared by the verification of false
+    /// candidates exceed the bytes scanned by this factor, plus simd_scan_slack.
+    static const long simd_scan_budget = 2;
+
+    /// The verification bytes allowed before the budget applies.
+    static const long simd_scan_slack = 4096;
+
+
+    static inline long simd_scan_kmp(const char* pattern, const char* text, long length, long text_length,
+                                     const long* failure_link, long from);
+
+
+#ifdef ALGORITHM_SIMDSEARCH_X86
+
+    /// Verify the candidate positions of the block at \b i, the set bits of \b mask, and
+    /// count the bytes compared for the false ones into \b work.
+    static inline long simd_scan_verify(unsigned mask, const char* pattern, const char* text, long length,
+                                        long i, long* work)
+    {
+        while (mask != 0) {
+            long pos = i + __builtin_ctz(mask);
+            if (std::memcmp(text + pos, pattern, length) == 0) {
+                return pos;
+            }
+            *work += length;
+            mask &= mask - 1;
+        }
+        return -1;
+    }
+
+
+    /// Each block of 16 positions is filtered by comparing the first byte of the pattern with
+    /// the block and a second byte, at offset \b second in the pattern, with the block shifted
+    /// by that offset; only the positions matching both are verified. Every candidate of a
+    /// block fits in the text, and the positions left are scanned by KMP.
+    /// \par References:
+    /// \li W. Mula. SIMD-friendly algorithms for substring searching. 2016.
+    ///     http://0x80.pl/articles/simd-strfind.html
+    static inline long simd_scan_sse2(const char* pattern, const char* text, long length, long text_length,
+                                      const long* failure_link, long second)
+    {
+        const __m128i first_byte = _mm_set1_epi8(pattern[0]);
+        const __m128i second_byte = _mm_set1_epi8(pattern[second]);
+        long work = 0;
+        long i = 0;
+
+        for (; i + 16 + length - 1 <= text_length; i += 16) {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i + second));
+            __m128i eq = _mm_and_si128(_mm_cmpeq_epi8(a, first_byte), _mm_cmpeq_epi8(b, second_byte));
+            unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(eq));
+            if (mask != 0) {
+                long pos = simd_scan_verify(mask, pattern, text, length, i, &work);
+                if (pos >= 0) {
+                    return pos;
+                }
+                if (work > simd_scan_budget * i + simd_scan_slack) {
+                    break;
+                }
+            }
+        }
+        return simd_scan_kmp(pattern, text, length, text_length, failure_link, i);
+    }
+
+
+    /// The filter of simd_scan_sse2() on blocks of 32 positions.
+    static __attribute__((target("avx2"))) long simd_scan_avx2(
+        const char* pattern, const char* text, long length, long text_length,
+        const long* failure_link, long second)
+    {
+        const __m256i first_byte = _mm256_set1_epi8(pattern[0]);
+        const __m256i second_byte = _mm256_set1_epi8(pattern[second]);
+        long work = 0;
+        long i = 0;
+
+        for (; i + 32 + length - 1 <= text_length; i += 32) {
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i));
+            __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i + second));
+            __m256i eq = _mm256_and_si256(_mm256_cmpeq_epi8(a, first_byte), _mm256_cmpeq_epi8(b, second_byte));
+            unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(eq));
+            if (mask != 0) {
+                long pos = simd_scan_verify(mask, pattern, text, length, i, &work);
+                if (pos >= 0) {
+                    return pos;
+                }
+                if (work > simd_scan_budget * i + simd_scan_slack) {
+                    break;
+                }
+            }
+        }
+        return simd_scan_kmp(pattern, text, length, text_length, failure_link, i);
+    }
+
+#endif // ALGORITHM_SIMDSEARCH_X86
+
+
+    /// The second filtered byte is the last byte of the pattern differing from its first
+    /// byte, so that patterns such as "aaab" are not filtered on two equal bytes.
+    inline long simd_scan(const char* pattern, const char* text, long length, long text_length,
+                          const long* failure_link)
+    {
+        assert(length > 0);
+        assert(text_length >= 0);
+
+        if (length > text_length) {
+            return -1;
+        }
+        if (length == 1) {
+            const void* p = std::memchr(text, pattern[0], text_length);
+            return (p == NULL) ? -1 : static_cast<const char*>(p) - text;
+        }
+
+#ifdef ALGORITHM_SIMDSEARCH_X86
+        long second = length - 1;
+        while (second > 1 && pattern[second] == pattern[0]) {
+            second--;
+        }
+        if (__builtin_cpu_supports("avx2")) {
+            return simd_scan_avx2(pattern, text, length, text_length, failure_link, second);
+        }
+        return simd_scan_sse2(pattern, text, length, text_length, failure_link, second);
+#else
+        return simd_scan_kmp(pattern, text, length, text_length, failure_link, 0);
+#endif
+    }
+
+
+    /// Find the first occurrence starting at \b from or after with a KmpMatcher, which keeps
+    /// the worst case linear.
+    long simd_scan_kmp(const char* pattern, const char* text, long length, long text_length,
+                       const long* failure_link, long from)
+    {
+        KmpMatcher matcher(pattern, length, failure_link);
+        long match, consumed;
+
+        if (matcher.scan(text + from, text_length - from, &match, 1, &consumed) == 0) {
+            return -1;
+        }
+        return from + match;
+    }
+} // namespace algorithm
+
+#endif // SIMDSEARCH_H
@@ -0,0 +1,439 @@
+/*
+# Copyright (c) 2008 Chung Shin Yee <cshinyee@gmail.com>
+#
+#       http://github.com/xman
+#       http://myxman.org
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License as
+# published by the Free Software Foundation; either version 2 of the
+# License, or (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+# USA.
+#
+# The GNU General Public License is contained in the file COPYING.
+#
+*/
+
+// Bitonic sorting and merging networks on AVX2 registers, for the leaves of the
+// comparison sorts. The networks are compiled for AVX2 whatever the compiler flags,
+// and used only when the CPU reports AVX2 at run time.
+
+#ifndef SORTNETWORK_H
+#define SORTNETWORK_H
+
+#include <cassert>
+#include <algorithm>
+#include <limits>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define ALGORITHM_SORTNETWORK_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace algorithm
+{
+    /// The maximum number of elements sorted by network_sort().
+    static const long network_sort_max = 64;
+
+    /// \brief Sort up to network_sort_max elements with a SIMD sorting network.
+    /// \param T The data type of the elements, int, long, float or double for a network.
+    /// \param[in,out] data The pointer to the list of elements.
+    /// \param[in] length The number of elements.
+    /// \return true if the elements are sorted, false if there is no network for \b T,
+    ///         \b length or this CPU, and the caller must sort them.
+    /// \note Equal floating-point keys such as -0.0 and +0.0 may be reordered.
+    template <typename T>
+    bool network_sort(T* data, long length);
+
+    /// \brief Same as network_sort(), but only for the types whose equal keys cannot be told apart,
+    ///        so the result is the one a stable sort gives.
+    template <typename T>
+    bool network_sort_stable(T* data, long length);
+
+    /// \brief Merge two sorted runs with a SIMD merging network.
+    /// \param T The data type of the elements, int or long for a network.
+    /// \param[in] a The first sorted run.
+    /// \param[in] na The number of elements in \b a.
+    /// \param[in] b The second sorted run.
+    /// \param[in] nb The number of elements in \b b.
+    /// \param[out] out The output of \b na + \b nb elements.
+    /// \return true if the runs are merged, false if there is no network for \b T or this CPU.
+    template <typename T>
+    bool network_merge(const T* a, long na, const T* b, long nb, T* out);
+
+    bool network_sort(int* data, long length);
+    bool network_sort(long* data, long length);
+    bool network_sort(float* data, long length);
+    bool network_sort(double* data, long length);
+    bool network_sort_stable(int* data, long length);
+    bool network_sort_stable(long* data, long length);
+    bool network_merge(const int* a, long na, const int* b, long nb, int* out);
+    bool network_merge(const long* a, long na, const long* b, long nb, long* out);
+} // namespace algorithm
+
+
+// ===================================================================
+// Implementation
+// ===================================================================
+
+namespace algorithm
+{
+    template <typename T>
+    inline bool network_sort(T*, long)
+    {
+        return false;
+    }
+
+
+    template <typename T>
+    inline bool network_sort_stable(T*, long)
+    {
+        return false;
+    }
+
+
+    template <typename T>
+    inline bool network_merge(const T*, long, const T*, long, T*)
+    {
+        return false;
+    }
+
+
+#ifdef ALGORITHM_SORTNETWORK_AVX2
+
+#define ALGORITHM_AVX2 __attribute__((target("avx2"), always_inline))
+
+    /// \brief The AVX2 operations on a register of T, with masks held in registers of the same type.
+    template <typename T>
+    class Avx2Lanes;
+
+    template <>
+    class Avx2Lanes<int>
+    {
+    public:
+        typedef __m256i Reg;
+        enum { width = 8 };
+        static inline ALGORITHM_AVX2 Reg load(const int* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+        static inline ALGORITHM_AVX2 void store(int* p, Reg v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+        static inline ALGORITHM_AVX2 Reg gt(Reg a, Reg b) { return _mm256_cmpgt_epi32(a, b); }
+        static inline ALGORITHM_AVX2 Reg blend(Reg a, Reg b, Reg m) { return _mm256_blendv_epi8(a, b, m); }
+        static inline ALGORITHM_AVX2 Reg mask_xor(Reg a, Reg b) { return _mm256_xor_si256(a, b); }
+        static inline ALGORITHM_AVX2 Reg mask_select(Reg m, Reg a, Reg b) { return _mm256_or_si256(_mm256_and_si256(m, a), _mm256_andnot_si256(m, b)); }
+        static inline ALGORITHM_AVX2 Reg ones(void) { return _mm256_set1_epi32(-1); }
+        static inline ALGORITHM_AVX2 Reg zeros(void) { return _mm256_setzero_si256(); }
+        static inline ALGORITHM_AVX2 Reg lane_mask(long bit)
+        {
+            __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+            __m256i b = _mm256_set1_epi32(static_cast<int>(bit));
+            return _mm256_cmpeq_epi32(_mm256_and_si256(lane, b), b);
+        }
+        static inline ALGORITHM_AVX2 Reg permute_xor(Reg v, long j)
+        {
+            __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+            return _mm256_permutevar8x32_epi32(v, _mm256_xor_si256(lane, _mm256_set1_epi32(static_cast<int>(j))));
+        }
+        static inline ALGORITHM_AVX2 Reg reverse(Reg v)
+        {
+            return _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+        }
+    };
+
+    template <>
+    class Avx2Lanes<float>
+    {
+    public:
+        typedef __m256 Reg;
+        enum { width = 8 };
+        static inline ALGORITHM_AVX2 Reg load(const float* p) { return _mm256_loadu_ps(p); }
+        static inline ALGORITHM_AVX2 void store(float* p, Reg v) { _mm256_storeu_ps(p, v); }
+        static inline ALGORITHM_AVX2 Reg gt(Reg a, Reg b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+        static inline ALGORITHM_AVX2 Reg blend(Reg a, Reg b, Reg m) { return _mm256_blendv_ps(a, b, m); }
+        static inline ALGORITHM_AVX2 Reg mask_xor(Reg a, Reg b) { return _mm256_xor_ps(a, b); }
+        static inline ALGORITHM_AVX2 Reg mask_select(Reg m, Reg a, Reg b) { return _mm256_or_ps(_mm256_and_ps(m, a), _mm256_andnot_ps(m, b)); }
+        static inline ALGORITHM_AVX2 Reg ones(void) { return _mm256_castsi256_ps(_mm256_set1_epi32(-1)); }
+        static inline ALGORITHM_AVX2 Reg zeros(void) { return _mm256_setzero_ps(); }
+        static inline ALGORITHM_AVX2 Reg lane_mask(long bit) { return _mm256_castsi256_ps(Avx2Lanes<int>::lane_mask(bit)); }
+        static inline ALGORITHM_AVX2 Reg permute_xor(Reg v, long j)
+        {
+            return _mm256_castsi256_ps(Avx2Lanes<int>::permute_xor(_mm256_castps_si256(v), j));
+        }
+        static inline ALGORITHM_AVX2 Reg reverse(Reg v)
+        {
+            return _mm256_castsi256_ps(Avx2Lanes<int>::reverse(_mm256_castps_si256(v)));
+        }
+    };
+
+    template <>
+    class Avx2Lanes<long>
+    {
+    public:
+        typedef __m256i Reg;
+        enum { width = 4 };
+        static inline ALGORITHM_AVX2 Reg load(const long* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+        static inline ALGORITHM_AVX2 void store(long* p, Reg v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+        static inline ALGORITHM_AVX2 Reg gt(Reg a, Reg b) { return _mm256_cmpgt_epi64(a, b); }
+        static inline ALGORITHM_AVX2 Reg blend(Reg a, Reg b, Reg m) { return _mm256_blendv_epi8(a, b, m); }
+        static inline ALGORITHM_AVX2 Reg mask_xor(Reg a, Reg b) { return _mm256_xor_si256(a, b); }
+        static inline ALGORITHM_AVX2 Reg mask_select(Reg m, Reg a, Reg b) { return _mm256_or_si256(_mm256_and_si256(m, a), _mm256_andnot_si256(m, b)); }
+        static inline ALGORITHM_AVX2 Reg ones(void) { return _mm256_set1_epi64x(-1); }
+        static inline ALGORITHM_AVX2 Reg zeros(void) { return _mm256_setzero_si256(); }
+        static inline ALGORITHM_AVX2 Reg lane_mask(long bit)
+        {
+            __m256i lane = _mm256_setr_epi64x(0, 1, 2, 3);
+            __m256i b = _mm256_set1_epi64x(bit);
+            return _mm256_cmpeq_epi64(_mm256_and_si256(lane, b), b);
+        }
+        static inline ALGORITHM_AVX2 Reg permute_xor(Reg v, long j)
+        {
+            return (j == 1) ? _mm256_permute4x64_epi64(v, 0xb1) : _mm256_permute4x64_epi64(v, 0x4e);
+        }
+        static inline ALGORITHM_AVX2 Reg reverse(Reg v) { return _mm256_permute4x64_epi64(v, 0x1b); }
+    };
+
+    template <>
+    class Avx2Lanes<double>
+    {
+    public:
+        typedef __m256d Reg;
+        enum { width = 4 };
+        static inline ALGORITHM_AVX2 Reg load(const double* p) { return _mm256_loadu_pd(p); }
+        static inline ALGORITHM_AVX2 void store(double* p, Reg v) { _mm256_storeu_pd(p, v); }
+        static inline ALGORITHM_AVX2 Reg gt(Reg a, Reg b) { return _mm256_cmp_pd(a, b, _CMP_GT_OQ); }
+        static inline ALGORITHM_AVX2 Reg blend(Reg a, Reg b, Reg m) { return _mm256_blendv_pd(a, b, m); }
+        static inline ALGORITHM_AVX2 Reg mask_xor(Reg a, Reg b) { return _mm256_xor_pd(a, b); }
+        static inline ALGORITHM_AVX2 Reg mask_select(Reg m, Reg a, Reg b) { return _mm256_or_pd(_mm256_and_pd(m, a), _mm256_andnot_pd(m, b)); }
+        static inline ALGORITHM_AVX2 Reg ones(void) { return _mm256_castsi256_pd(_mm256_set1_epi64x(-1)); }
+        static inline ALGORITHM_AVX2 Reg zeros(void) { return _mm256_setzero_pd(); }
+        static inline ALGORITHM_AVX2 Reg lane_mask(long bit) { return _mm256_castsi256_pd(Avx2Lanes<long>::lane_mask(bit)); }
+        static inline ALGORITHM_AVX2 Reg permute_xor(Reg v, long j)
+        {
+            return _mm256_castsi256_pd(Avx2Lanes<long>::permute_xor(_mm256_castpd_si256(v), j));
+        }
+        static inline ALGORITHM_AVX2 Reg reverse(Reg v) { return _mm256_permute4x64_pd(v, 0x1b); }
+    };
+
+
+    /// \brief Compare-exchange lanes \b j apart within every register of \b x, ascending where
+    ///        the index bit \b k is clear and descending where it is set.<br>
+    ///        Both lanes of a pair swap on the same comparison, so no value is duplicated
+    ///        even when equal keys differ, like -0.0 and +0.0.
+    template <typename T>
+    static inline ALGORITHM_AVX2 typename Avx2Lanes<T>::Reg
+    bitonic_lanes(typename Avx2Lanes<T>::Reg v, long j, typename Avx2Lanes<T>::Reg descending)
+    {
+        typedef Avx2Lanes<T> L;
+        typedef typename L::Reg Reg;
+
+        Reg p = L::permute_xor(v, j);
+        Reg take_lower = L::mask_xor(L::mask_xor(L::lane_mask(j), L::ones()), descending);
+        Reg swap = L::mask_select(take_lower, L::gt(v, p), L::gt(p, v));
+        return L::blend(v, p, swap);
+    }
+
+
+    /// Bitonic sort of the \b n elements of \b x, n a power of two and at least a register wide.
+    /// \par References:
+    /// K. E. Batcher. Sorting Networks and Their Applications. AFIPS Spring Joint Computer Conference, 1968.
+    template <typename T>
+    static __attribute__((target("avx2"))) void bitonic_sort_avx2(T* x, long n)
+    {
+        typedef Avx2Lanes<T> L;
+        typedef typename L::Reg Reg;
+        const long w = L::width;
+
+        for (long k = 2; k <= n; k <<= 1) {
+            for (long j = k >> 1; j > 0; j >>= 1) {
+                for (long i = 0; i < n; i += w) {
+                    if (j >= w) {
+                        if (i & j) {
+                            continue;
+                        }
+                        Reg a = L::load(x + i);
+                        Reg b = L::load(x + i + j);
+                        Reg swap = (i & k) ? L::gt(b, a) : L::gt(a, b);
+                        L::store(x + i, L::blend(a, b, swap));
+                        L::store(x + i + j, L::blend(b, a, swap));
+                    } else {
+                        Reg descending = (k >= w) ? ((i & k) ? L::ones() : L::zeros()) : L::lane_mask(k);
+                        L::store(x + i, bitonic_lanes<T>(L::load(x + i), j, descending));
+                    }
+                }
+            }
+        }
+    }
+
+
+    /// Pad \b data to a power of two with the largest key and sort it with the network.
+    /// The caller checks for AVX2 before calling any AVX2 code.
+    template <typename T>
+    static __attribute__((target("avx2"))) bool network_sort_avx2(T* data, long length)
+    {
+        T x[network_sort_max];
+        const long w = Avx2Lanes<T>::width;
+
+        if (length < 2 || length > network_sort_max) {
+            return false;
+        }
+
+        long n = w;
+        while (n < length) {
+            n <<= 1;
+        }
+        T pad = std::numeric_limits<T>::has_infinity ? std::numeric_limits<T>::infinity()
+                                                     : std::numeric_limits<T>::max();
+        std::copy(data, data + length, x);
+        std::fill(x + length, x + n, pad);
+
+        bitonic_sort_avx2(x, n);
+
+        std::copy(x, x + length, data);
+        return true;
+    }
+
+
+    /// \brief Merge two sorted registers: \b lo receives the smallest half, \b hi the largest, both sorted.
+    template <typename T>
+    static inline ALGORITHM_AVX2 void bitonic_merge_avx2(typename Avx2Lanes<T>::Reg& lo, typename Avx2Lanes<T>::Reg& hi)
+    {
+        typedef Avx2Lanes<T> L;
+        typedef typename L::Reg Reg;
+
+        Reg b = L::reverse(hi);
+        Reg swap = L::gt(lo, b);
+        Reg a = L::blend(lo, b, swap);
+        b = L::blend(b, lo, swap);
+        for (long j = L::width / 2; j > 0; j >>= 1) {
+            a = bitonic_lanes<T>(a, j, L::zeros());
+            b = bitonic_lanes<T>(b, j, L::zeros());
+        }
+        lo = a;
+        hi = b;
+    }
+
+
+    /// Merge one register at a time from whichever run has the smaller next key, keeping the
+    /// larger half of each merge for the next step. The tails are merged with the carried half.
+    /// \par References:
+    /// H. Inoue and K. Taura. SIMD- and Cache-Friendly Algorithm for Sorting an Array of Structures.
+    /// Proceedings of the VLDB Endowment, 8(11), 2015.
+    template <typename T>
+    static __attribute__((target("avx2"))) bool network_merge_avx2(const T* a, long na, const T* b, long nb, T* out)
+    {
+        typedef Avx2Lanes<T> L;
+        typedef typename L::Reg Reg;
+        const long w = L::width;
+
+        if (na < w || nb < w) {
+            return false;
+        }
+
+        Reg lo = L::load(a);
+        Reg hi = L::load(b);
+        long ia = w, ib = w;
+        for (;;) {
+            bitonic_merge_avx2<T>(lo, hi);
+            L::store(out, lo);
+            out += w;
+
+            bool from_a = (ib >= nb) || (ia < na && a[ia] <= b[ib]);
+            if (from_a && ia + w <= na) {
+                lo = L::load(a + ia);
+                ia += w;
+            } else if (!from_a && ib + w <= nb) {
+                lo = L::load(b + ib);
+                ib += w;
+            } else {
+                break;
+            }
+        }
+
+        // Three-way merge of the carried register with the tails.
+        T carry[network_sort_max];
+        L::store(carry, hi);
+        long ic = 0;
+        while (ic < w || ia < na || ib < nb) {
+            if (ic < w && (ia >= na || carry[ic] <= a[ia]) && (ib >= nb || carry[ic] <= b[ib])) {
+                *out++ = carry[ic++];
+            } else if (ia < na && (ib >= nb || a[ia] <= b[ib])) {
+                *out++ = a[ia++];
+            } else {
+                *out++ = b[ib++];
+            }
+        }
+        return true;
+    }
+
+#undef ALGORITHM_AVX2
+
+
+    inline bool network_sort(int* data, long length)
+    {
+        return __builtin_cpu_supports("avx2") && network_sort_avx2(data, length);
+    }
+
+
+    inline bool network_sort(long* data, long length)
+    {
+        return __builtin_cpu_supports("avx2") && network_sort_avx2(data, length);
+    }
+
+
+    inline bool network_sort(float* data, long length)
+    {
+        return __builtin_cpu_supports("avx2") && network_sort_avx2(data, length);
+    }
+
+
+    inline bool network_sort(double* data, long length)
+    {
+        return __builtin_cpu_supports("avx2") && network_sort_avx2(data, length);
+    }
+
+
+    inline bool network_sort_stable(int* data, long length)
+    {
+        return __builtin_cpu_supports("avx2") && network_sort_avx2(data, length);
+    }
+
+
+    inline bool network_sort_stable(long* data, long length)
+    {
+        return __builtin_cpu_supports("avx2") && network_sort_avx2(data, length);
+    }
+
+
+    inline bool network_merge(const int* a, long na, const int* b, long nb, int* out)
+    {
+        return __builtin_cpu_supports("avx2") && network_merge_avx2(a, na, b, nb, out);
+    }
+
+
+    inline bool network_merge(const long* a, long na, const long* b, long nb, long* out)
+    {
+        return __builtin_cpu_supports("avx2") && network_merge_avx2(a, na, b, nb, out);
+    }
+
+#else
+
+    inline bool network_sort(int*, long) { return false; }
+    inline bool network_sort(long*, long) { return false; }
+    inline bool network_sort(float*, long) { return false; }
+    inline bool network_sort(double*, long) { return false; }
+    inline bool network_sort_stable(int*, long) { return false; }
+    inline bool network_sort_stable(long*, long) { return false; }
+    inline bool network_merge(const int*, long, const int*, long, int*) { return false; }
+    inline bool network_merge(const long*, long, const long*, long, long*) { return false; }
+
+#endif // ALGORITHM_SORTNETWORK_AVX2
+} // namespace algorithm
+
+#endif // SORTNETWORK_H
@@ -0,0 +1,532 @@
+/*
+# Copyright (c) 2008 Chung Shin Yee <cshinyee@gmail.com>
+#
+#       http://github.com/xman
+#       http://myxman.org
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License as
+# published by the Free Software Foundation; either version 2 of the
+# License, or (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+# USA.
+#
+# The GNU General Public License is contained in the file COPYING.
+#
+*/
+
+// Single-pattern string search choosing among Horspool, Two-Way and KMP for each pattern.
+
+#ifndef STRINGSEARCH_H
+#define STRINGSEARCH_H
+
+#include <cassert>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include "kmp.h"
+#include "simdsearch.h"
+
+namespace algorithm
+{
+    /// \brief The search algorithm of a StringSearch.
+    typedef enum {
+        STRINGSEARCH_KMP, ///< KMP behind the SIMD filter of simd_scan(): linear, best on short patterns.
+        STRINGSEARCH_HORSPOOL, ///< Boyer-Moore-Horspool: skips up to the pattern length, O(nm) worst case.
+        STRINGSEARCH_TWO_WAY ///< Crochemore-Perrin Two-Way with the Horspool shift: skips, linear worst case.
+    } StringSearchMethod;
+
+    /// \brief A pattern with the tables of its search algorithm, set up once and used for
+    ///        any number of texts.
+    class StringSearch
+    {
+    public:
+        /// \brief Set up the search for \b pattern, choosing the algorithm by the length and
+        ///        the byte entropy of the pattern.
+        /// \param[in] pattern The pattern string, which may contain NUL bytes. It is copied.
+        /// \param[in] length The length of the pattern string.
+        StringSearch(const char* pattern, long length);
+
+        /// \brief Set up the search for \b pattern with the given algorithm.
+        StringSearch(const char* pattern, long length, StringSearchMethod method);
+        ~StringSearch(void);
+
+        /// \brief Get the algorithm chosen.
+        StringSearchMethod method(void) const;
+
+        /// \brief Get the length of the pattern.
+        long length(void) const;
+
+        /// \brief Find the first occurrence of the pattern in the text.
+        /// \param[in] text The text string, which may contain NUL bytes.
+        /// \param[in] text_length The length of the text string.
+        /// \param[in] from The index in \b text where the search starts.
+        /// \return The index in \b text where the first copy of the pattern from \b from begins.
+        /// \return -1 if no match is found.
+        long find(const char* text, long text_length, long from = 0) const;
+
+        /// \brief Find every occurrence of the pattern in the text, overlapping ones included.
+        /// \param F The type of a function or function object called as report(offset).
+        /// \param[in] text The text string, which may contain NUL bytes.
+        /// \param[in] text_length The length of the text string.
+        /// \param[in] report Called with the index in \b text of each occurrence, in increasing order.
+        /// \return The number of occurrences.
+        template <typename F>
+        long find_all(const char* text, long text_length, F report) const;
+
+        /// \brief Find the occurrences of the pattern in the text until \b capacity of them
+        ///        are found.
+        /// \param[out] offsets The indexes in \b text of the occurrences, in increasing order.
+        /// \param[in] capacity The maximum number of offsets to store.
+        /// \return The number of offsets stored. When it is \b capacity, the search can go on
+        ///         with find() from the last offset plus one.
+        long find_all(const char* text, long text_length, long* offsets, long capacity) const;
+
+    private:
+        void setup(StringSearchMethod method);
+
+        template <typename F>
+        long kmp(const char* text, long text_length, F& report) const;
+
+        template <typename F>
+        long horspool(const char* text, long text_length, long from, F& report) const;
+
+        template <typename F>
+        long two_way(const char* text, long text_length, long from, F& report) const;
+
+        /// \brief Get the start of the maximal suffix of the pattern for the byte order, or its
+        ///        reverse, and the period of that suffix.
+        long maximal_suffix(bool reverse, long* period) const;
+
+        std::vector<char> m_pattern; ///< The pattern string.
+        long m_length; ///< The length of the pattern string.
+        StringSearchMethod m_method; ///< The algorithm.
+        std::vector<long> m_failure_link; ///< The KMP failure links.
+        std::vector<long> m_shift; ///< The Horspool shift of each byte at the last window position.
+        long m_critical; ///< The Two-Way critical position, the end of the left part.
+        long m_period; ///< The Two-Way shift after matching the right part.
+        bool m_periodic; ///< Does the left part recur a period later, so it needs remembering?
+    };
+} // namespace algorithm
+
+
+// ===================================================================
+// Implementation
+// ===================================================================
+
+namespace algorithm
+{
+    /// The patterns with less than this byte entropy, in bits, are of a small alphabet.
+    static const double string_search_entropy = 3.0;
+
+    /// The patterns of a large alphabet shorter than this are searched with simd_scan(),
+    /// the longer ones with Horspool.
+    static const long string_search_short = 256;
+
+    /// The patterns of a small alphabet shorter than this are searched with simd_scan(),
+    /// the longer ones with Two-Way.
+    static const long string_search_short_small_alphabet = 48;
+
+    /// find_all() with STRINGSEARCH_KMP hands over to the KMP matcher once the occurrences
+    /// are closer than this number of bytes on average.
+    static const long string_search_dense = 256;
+
+
+    /// \brief Stop at the first occurrence.
+    typedef struct {
+        long offset; ///< The occurrence, -1 if none.
+    } StringSearchFirst;
+
+    /// \brief Store the occurrences into an array until it is full.
+    typedef struct {
+        long* offsets; ///< The array.
+        long capacity; ///< The size of the array.
+        long count; ///< The number of occurrences stored.
+    } StringSearchStore;
+
+    template <typename F>
+    class StringSearchAll;
+
+
+    static inline bool string_search_report(StringSearchFirst& first, long offset);
+    static inline bool string_search_report(StringSearchStore& store, long offset);
+    template <typename F>
+    static inline bool string_search_report(StringSearchAll<F>& all, long offset);
+
+    static inline long string_search_kmp(KmpMatcher& matcher, const char* text, long length, long base,
+                                         StringSearchStore& store);
+    template <typename F>
+    static inline long string_search_kmp(KmpMatcher& matcher, const char* text, long length, long base,
+                                         StringSearchAll<F>& all);
+
+
+    /// \brief Forward every occurrence to a callback, offset by \b base.
+    template <typename F>
+    class StringSearchAll
+    {
+    public:
+        StringSearchAll(F& report, long base) : m_report(report), m_base(base)
+        {
+        }
+
+        void operator()(long offset)
+        {
+            m_report(m_base + offset);
+        }
+
+        F& m_report; ///< The callback.
+        long m_base; ///< The offset added to every occurrence.
+    };
+
+
+    /// The filter of simd_scan() is the fastest on short patterns, until the false candidates
+    /// of long patterns send it to KMP, sooner on a small alphabet. Beyond, Horspool skips
+    /// the most on a large alphabet, while on a small one its windows often end with a byte
+    /// of the pattern, and a repetitive text makes it quadratic where Two-Way is linear.
+    inline StringSearch::StringSearch(const char* pattern, long length) :
+        m_pattern(pattern, pattern + length), m_length(length), m_method(STRINGSEARCH_KMP),
+        m_failure_link(), m_shift(), m_critical(0), m_period(0), m_periodic(false)
+    {
+        assert(length > 0);
+
+        long count[256] = { 0 };
+        for (long i = 0; i < length; i++) {
+            count[static_cast<unsigned char>(pattern[i])]++;
+        }
+        double entropy = 0;
+        for (int c = 0; c < 256; c++) {
+            if (count[c] > 0) {
+                double p = static_cast<double>(count[c]) / length;
+                entropy -= p * std::log(p);
+            }
+        }
+        entropy /= std::log(2.0);
+
+        if (entropy >= string_search_entropy) {
+            setup(length < string_search_short ? STRINGSEARCH_KMP : STRINGSEARCH_HORSPOOL);
+        } else {
+            setup(length < string_search_short_small_alphabet ? STRINGSEARCH_KMP : STRINGSEARCH_TWO_WAY);
+        }
+    }
+
+
+    inline StringSearch::StringSearch(const char* pattern, long length, StringSearchMethod method) :
+        m_pattern(pattern, pattern + length), m_length(length), m_method(method),
+        m_failure_link(), m_shift(), m_critical(0), m_period(0), m_periodic(false)
+    {
+        assert(length > 0);
+
+        setup(method);
+    }
+
+
+    inline StringSearch::~StringSearch(void)
+    {
+    }
+
+
+    inline StringSearchMethod StringSearch::method(void) const
+    {
+        return m_method;
+    }
+
+
+    inline long StringSearch::length(void) const
+    {
+        return m_length;
+    }
+
+
+    /// KMP needs its failure links, Horspool and Two-Way share the shift table.
+    inline void StringSearch::setup(StringSearchMethod method)
+    {
+        const char* x = &m_pattern[0];
+        long m = m_length;
+
+        m_method = method;
+        if (method == STRINGSEARCH_KMP) {
+            m_failure_link.resize(m);
+            kmp_setup(x, m, &m_failure_link[0]);
+            return;
+        }
+
+        m_shift.assign(256, m);
+        for (long i = 0; i < m - 1; i++) {
+            m_shift[static_cast<unsigned char>(x[i])] = m - 1 - i;
+        }
+        if (method == STRINGSEARCH_TWO_WAY) {
+            // The critical factorization is at the later of the two maximal suffixes.
+            long p1, p2;
+            long s1 = maximal_suffix(false, &p1);
+            long s2 = maximal_suffix(true, &p2);
+            m_critical = (s1 > s2) ? s1 : s2;
+            m_period = (s1 > s2) ? p1 : p2;
+
+            m_periodic = (m_critical + 1 + m_period <= m) &&
+                         std::memcmp(x, x + m_period, m_critical + 1) == 0;
+            if (!m_periodic) {
+                m_period = std::max(m_critical + 1, m - m_critical - 1) + 1;
+            }
+        }
+    }
+
+
+    inline long StringSearch::find(const char* text, long text_length, long from) const
+    {
+        assert(from >= 0);
+
+        if (from + m_length > text_length) {
+            return -1;
+        }
+        if (m_method == STRINGSEARCH_KMP) {
+            long i = simd_scan(&m_pattern[0], text + from, m_length, text_length - from, &m_failure_link[0]);
+            return (i < 0) ? -1 : from + i;
+        }
+
+        StringSearchFirst first = { -1 };
+        if (m_method == STRINGSEARCH_HORSPOOL) {
+            horspool(text, text_length, from, first);
+        } else {
+            two_way(text, text_length, from, first);
+        }
+        return first.offset;
+    }
+
+
+    template <typename F>
+    long StringSearch::find_all(const char* text, long text_length, F report) const
+    {
+        StringSearchAll<F> all(report, 0);
+        if (m_method == STRINGSEARCH_KMP) {
+            return kmp(text, text_length, all);
+        }
+        if (m_method == STRINGSEARCH_HORSPOOL) {
+            return horspool(text, text_length, 0, all);
+        }
+        return two_way(text, text_length, 0, all);
+    }
+
+
+    inline long StringSearch::find_all(const char* text, long text_length, long* offsets, long capacity) const
+    {
+        assert(capacity > 0);
+
+        StringSearchStore store = { offsets, capacity, 0 };
+        if (m_method == STRINGSEARCH_KMP) {
+            kmp(text, text_length, store);
+        } else if (m_method == STRINGSEARCH_HORSPOOL) {
+            horspool(text, text_length, 0, store);
+        } else {
+            two_way(text, text_length, 0, store);
+        }
+        return store.count;
+    }
+
+
+    /// simd_scan() is run again after every occurrence, which pays while they are sparse. Its
+    /// verification budget starts afresh every time, so dense occurrences go to the KMP
+    /// matcher, which finds them all in one linear pass.
+    template <typename F>
+    long StringSearch::kmp(const char* text, long text_length, F& report) const
+    {
+        long found = 0;
+        long from = 0;
+
+        while (found * string_search_dense <= from + simd_scan_slack) {
+            long p = find(text, text_length, from);
+            if (p < 0) {
+                return found;
+            }
+            found++;
+            if (!string_search_report(report, p)) {
+                return found;
+            }
+            from = p + 1;
+        }
+
+        KmpMatcher matcher(&m_pattern[0], m_length, &m_failure_link[0]);
+        return found + string_search_kmp(matcher, text + from, text_length - from, from, report);
+    }
+
+
+    /// The window is shifted by the distance from the last occurrence of its last byte in the
+    /// pattern, not counting the last position, to the end of the pattern.
+    /// \par References:
+    /// \li R. N. Horspool. Practical Fast Searching in Strings. Software: Practice and
+    ///     Experience, 10(6), 1980.
+    template <typename F>
+    long StringSearch::horspool(const char* text, long text_length, long from, F& report) const
+    {
+        const char* x = &m_pattern[0];
+        const long* shift = &m_shift[0];
+        long m = m_length;
+        char last = x[m - 1];
+        long found = 0;
+
+        for (long j = from; j + m <= text_length; ) {
+            char c = text[j + m - 1];
+            if (c == last && std::memcmp(text + j, x, m - 1) == 0) {
+                found++;
+                if (!string_search_report(report, j)) {
+                    break;
+                }
+            }
+            j += shift[static_cast<unsigned char>(c)];
+        }
+        return found;
+    }
+
+
+    /// The pattern is split at a critical position into a left and a right part. The right
+    /// part is compared left to right, and a mismatch shifts the window past the bytes
+    /// matched; then the left part is compared right to left, and a mismatch or a match
+    /// shifts the window by the period. When the pattern is periodic, the prefix matched
+    /// again after such a shift is remembered and not compared twice, which keeps the number
+    /// of comparisons below 2n.<br>
+    /// Before that, a window whose last byte differs from the last byte of the pattern is
+    /// shifted as by Horspool, and by no less than the remembered prefix allows, as glibc
+    /// does; without it, most mismatches on the first byte of the right part shift by one.
+    /// \par References:
+    /// \li M. Crochemore and D. Perrin. Two-Way String-Matching. Journal of the ACM, 38(3), 1991.
+    /// \li C. Charras and T. Lecroq. Handbook of Exact String Matching Algorithms. 2004.
+    template <typename F>
+    long StringSearch::two_way(const char* text, long text_length, long from, F& report) const
+    {
+        const char* x = &m_pattern[0];
+        const long* shift = &m_shift[0];
+        long m = m_length;
+        long ell = m_critical;
+        char last = x[m - 1];
+        long found = 0;
+        long memory = -1;
+
+        for (long j = from; j + m <= text_length; ) {
+            const char* y = text + j;
+            char c = y[m - 1];
+            if (c != last) {
+                long s = shift[static_cast<unsigned char>(c)];
+                if (memory >= 0 && s < m_period) {
+                    s = m - m_period;
+                }
+                j += s;
+                memory = -1;
+                continue;
+            }
+
+            long i = std::max(ell, memory) + 1;
+            while (i < m && x[i] == y[i]) {
+                i++;
+            }
+            if (i < m) {
+                j += i - ell;
+                memory = -1;
+                continue;
+            }
+
+            i = ell;
+            while (i > memory && x[i] == y[i]) {
+                i--;
+            }
+            if (i <= memory) {
+                found++;
+                if (!string_search_report(report, j)) {
+                    break;
+                }
+            }
+            j += m_period;
+            memory = m_periodic ? m - m_period - 1 : -1;
+        }
+        return found;
+    }
+
+
+    /// The maximal suffix is found by comparing two candidate suffixes, starting at \b ms + 1
+    /// and \b j + 1, at offset \b k, while \b p is the period of the better one.
+    inline long StringSearch::maximal_suffix(bool reverse, long* period) const
+    {
+        const unsigned char* x = reinterpret_cast<const unsigned char*>(&m_pattern[0]);
+        long ms = -1;
+        long j = 0;
+        long k = 1;
+        long p = 1;
+
+        while (j + k < m_length) {
+            unsigned char a = x[j + k];
+            unsigned char b = x[ms + k];
+            if (reverse ? (a > b) : (a < b)) {
+                j += k;
+                k = 1;
+                p = j - ms;
+            } else if (a == b) {
+                if (k != p) {
+                    k++;
+                } else {
+                    j += p;
+                    k = 1;
+                }
+            } else {
+                ms = j;
+                j = ms + 1;
+                k = 1;
+                p = 1;
+            }
+        }
+        *period = p;
+        return ms;
+    }
+
+
+    bool string_search_report(StringSearchFirst& first, long offset)
+    {
+        first.offset = offset;
+        return false;
+    }
+
+
+    bool string_search_report(StringSearchStore& store, long offset)
+    {
+        store.offsets[store.count++] = offset;
+        return store.count < store.capacity;
+    }
+
+
+    template <typename F>
+    bool string_search_report(StringSearchAll<F>& all, long offset)
+    {
+        all(offset);
+        return true;
+    }
+
+
+    long string_search_kmp(KmpMatcher& matcher, const char* text, long length, long base,
+                           StringSearchStore& store)
+    {
+        long* offsets = store.offsets + store.count;
+        long consumed;
+        long n = matcher.scan(text, length, offsets, store.capacity - store.count, &consumed);
+        for (long i = 0; i < n; i++) {
+            offsets[i] += base;
+        }
+        store.count += n;
+        return n;
+    }
+
+
+    template <typename F>
+    long string_search_kmp(KmpMatcher& matcher, const char* text, long length, long base,
+                           StringSearchAll<F>& all)
+    {
+        return matcher.scan(text, length, StringSearchAll<F>(all.m_report, all.m_base + base));
+    }
+} // namespace algorithm
+
+#endif // STRINGSEARCH_H
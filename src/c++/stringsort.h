@@ -0,0 +1,306 @@
+/*
+# Copyright (c) 2008 Chung Shin Yee <cshinyee@gmail.com>
+#
+#       http://github.com/xman
+#       http://myxman.org
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License as
+# published by the Free Software Foundation; either version 2 of the
+# License, or (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+# USA.
+#
+# The GNU General Public License is contained in the file COPYING.
+#
+*/
+
+#ifndef STRINGSORT_H
+#define STRINGSORT_H
+
+#include <cassert>
+#include <cstring>
+#include <algorithm>
+#include <string>
+
+/// \brief Load the characters of a string as a big-endian word, when there is a builtin for it.
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#if __SIZEOF_LONG__ == 8
+#define ALGORITHM_STRINGSORT_WORD(x) __builtin_bswap64(x)
+#elif __SIZEOF_LONG__ == 4
+#define ALGORITHM_STRINGSORT_WORD(x) __builtin_bswap32(x)
+#endif
+#endif
+
+namespace algorithm
+{
+    /// \brief Sort the \b length NUL-terminated strings using the Multikey Quicksort algorithm.
+    /// \param[in,out] data The pointer to the list of strings.
+    /// \param[in] length The number of strings.
+    /// \note The strings order as by strcmp(). Only the pointers move.
+    void string_sort(const char** data, long length);
+
+    /// \brief Sort the \b length strings using the Multikey Quicksort algorithm.
+    /// \param[in,out] data The pointer to the list of strings.
+    /// \param[in] length The number of strings.
+    /// \note The strings order as by std::string::compare().
+    void string_sort(std::string* data, long length);
+} // namespace algorithm
+
+
+// ===================================================================
+// Implementation
+// ===================================================================
+
+namespace algorithm
+{
+    /// The partitions with at most this number of strings are sorted by Insertion Sort.
+    static const long string_sort_cutoff = 16;
+
+    /// The number of characters packed in a cached key, leaving the low byte for their count.
+    static const long string_sort_chars = sizeof(unsigned long) - 1;
+
+
+    template <typename S>
+    static void multikey_quicksort(S* data, unsigned long* cache, long length, long depth, bool cached);
+
+    template <typename S>
+    static void string_insertion_sort(S* data, long length, long depth);
+
+    template <typename S>
+    static long string_sort_common_prefix(const S* data, long length, long depth);
+
+    static long string_sort_mismatch(const char* a, const char* b, long depth, long limit);
+
+    static long string_sort_mismatch(const std::string& a, const std::string& b, long depth, long limit);
+
+    static unsigned long string_sort_key(const char* s, long depth);
+
+    static unsigned long string_sort_key(const std::string& s, long depth);
+
+    static unsigned long string_sort_pack(const char* s, long n);
+
+    static bool string_sort_less(const char* a, const char* b, long depth);
+
+    static bool string_sort_less(const std::string& a, const std::string& b, long depth);
+
+
+    inline void string_sort(const char** data, long length)
+    {
+        assert(length > 0);
+
+        unsigned long* cache = new unsigned long[length];
+        assert(cache != NULL);
+
+        multikey_quicksort(data, cache, length, 0L, false);
+
+        delete[] cache;
+    }
+
+
+    inline void string_sort(std::string* data, long length)
+    {
+        assert(length > 0);
+
+        unsigned long* cache = new unsigned long[length];
+        assert(cache != NULL);
+
+        multikey_quicksort(data, cache, length, 0L, false);
+
+        delete[] cache;
+    }
+
+
+    /// All the strings of the partition share their first \b depth characters. The next
+    /// string_sort_chars characters of every string are read once into \b cache, packed in
+    /// an integer that orders as they do, and the partition is split three ways on it: the
+    /// smaller and greater sides keep the cache and the depth, the equal side goes that many
+    /// characters deeper. So every character is fetched O(1) times on average, a word at a
+    /// time, and long shared prefixes are never compared again.
+    /// \par References:
+    /// \li J. L. Bentley and R. Sedgewick. Fast Algorithms for Sorting and Searching Strings.
+    ///     SODA 1997.
+    /// \li J. Karkkainen and T. Rantala. Engineering Radix Sort for Strings. SPIRE 2008.
+    template <typename S>
+    void multikey_quicksort(S* data, unsigned long* cache, long length, long depth, bool cached)
+    {
+        while (length > string_sort_cutoff) {
+            if (!cached) {
+                for (long i = 0; i < length; i++) {
+                    cache[i] = string_sort_key(data[i], depth);
+                }
+            }
+
+            // Median of three cached keys.
+            unsigned long a = cache[0];
+            unsigned long b = cache[length / 2];
+            unsigned long c = cache[length - 1];
+            unsigned long pivot = (a < b) ? ((b < c) ? b : std::max(a, c))
+                                          : ((a < c) ? a : std::max(b, c));
+
+            long lt = 0;
+            long i = 0;
+            long gt = length - 1;
+            while (i <= gt) {
+                if (cache[i] < pivot) {
+                    std::swap(data[lt], data[i]);
+                    std::swap(cache[lt], cache[i]);
+                    lt++;
+                    i++;
+                } else if (pivot < cache[i]) {
+                    std::swap(data[i], data[gt]);
+                    std::swap(cache[i], cache[gt]);
+                    gt--;
+                } else {
+                    i++;
+                }
+            }
+
+            // The equal strings are done when they end within the key. When all the strings are
+            // equal, their whole common prefix is skipped at once instead of a key at a time.
+            if (lt == 0 && gt == length - 1) {
+                if (static_cast<long>(pivot & 0xff) != string_sort_chars) {
+                    return;
+                }
+                depth += string_sort_chars;
+                depth += string_sort_common_prefix(data, length, depth);
+                cached = false;
+                continue;
+            }
+            if (static_cast<long>(pivot & 0xff) == string_sort_chars) {
+                multikey_quicksort(data + lt, cache + lt, gt - lt + 1, depth + string_sort_chars, false);
+            }
+
+            // Recurse into the smaller of the smaller and greater sides and iterate on the
+            // larger one, so the stack depth is O(log n) at every depth.
+            if (lt < length - gt - 1) {
+                multikey_quicksort(data, cache, lt, depth, true);
+                data += gt + 1;
+                cache += gt + 1;
+                length -= gt + 1;
+            } else {
+                multikey_quicksort(data + gt + 1, cache + gt + 1, length - gt - 1, depth, true);
+                length = lt;
+            }
+            cached = true;
+        }
+        if (length > 1) {
+            string_insertion_sort(data, length, depth);
+        }
+    }
+
+
+    /// Insertion Sort of strings sharing their first \b depth characters, comparing the rest.
+    template <typename S>
+    void string_insertion_sort(S* data, long length, long depth)
+    {
+        for (long i = 1; i < length; i++) {
+            for (long j = i; j > 0 && string_sort_less(data[j], data[j-1], depth); j--) {
+                std::swap(data[j], data[j-1]);
+            }
+        }
+    }
+
+
+    /// Get the length of the prefix shared by the strings after their first \b depth characters.
+    template <typename S>
+    long string_sort_common_prefix(const S* data, long length, long depth)
+    {
+        long lcp = string_sort_mismatch(data[0], data[1], depth, -1L);
+        for (long i = 2; i < length && lcp > 0; i++) {
+            lcp = string_sort_mismatch(data[0], data[i], depth, lcp);
+        }
+        return lcp;
+    }
+
+
+    /// Count the equal characters of \b a and \b b from \b depth on, up to \b limit when it's
+    /// not negative.
+    inline long string_sort_mismatch(const char* a, const char* b, long depth, long limit)
+    {
+        long n = 0;
+        while ((limit < 0 || n < limit) && a[depth + n] == b[depth + n] && a[depth + n] != '\0') {
+            n++;
+        }
+        return n;
+    }
+
+
+    inline long string_sort_mismatch(const std::string& a, const std::string& b, long depth, long limit)
+    {
+        long n = static_cast<long>(std::min(a.size(), b.size())) - depth;
+        if (limit >= 0) {
+            n = std::min(n, limit);
+        }
+        const char* x = a.data() + depth;
+        const char* y = b.data() + depth;
+        long i = 0;
+        while (i + static_cast<long>(sizeof(unsigned long)) <= n
+               && std::memcmp(x + i, y + i, sizeof(unsigned long)) == 0) {
+            i += sizeof(unsigned long);
+        }
+        while (i < n && x[i] == y[i]) {
+            i++;
+        }
+        return i;
+    }
+
+
+    inline unsigned long string_sort_key(const char* s, long depth)
+    {
+        long n = 0;
+        while (n < string_sort_chars && s[depth + n] != '\0') {
+            n++;
+        }
+        return string_sort_pack(s + depth, n);
+    }
+
+
+    /// A whole word is loaded at once when the string has that many characters left.
+    inline unsigned long string_sort_key(const std::string& s, long depth)
+    {
+        long left = static_cast<long>(s.size()) - depth;
+#if defined(ALGORITHM_STRINGSORT_WORD)
+        if (left >= static_cast<long>(sizeof(unsigned long))) {
+            unsigned long word;
+            std::memcpy(&word, s.data() + depth, sizeof(word));
+            return (ALGORITHM_STRINGSORT_WORD(word) & ~0xffUL) | static_cast<unsigned long>(string_sort_chars);
+        }
+#endif
+        return string_sort_pack(s.data() + depth, std::min(string_sort_chars, left));
+    }
+
+
+    /// Pack \b n characters big-endian, padded with zeros, above their count in the low byte.
+    /// A string ending within the key orders before any continuation, even a NUL.
+    inline unsigned long string_sort_pack(const char* s, long n)
+    {
+        unsigned long key = 0;
+        for (long i = 0; i < string_sort_chars; i++) {
+            key = (key << 8) | ((i < n) ? static_cast<unsigned char>(s[i]) : 0);
+        }
+        return (key << 8) | static_cast<unsigned long>(n);
+    }
+
+
+    inline bool string_sort_less(const char* a, const char* b, long depth)
+    {
+        return std::strcmp(a + depth, b + depth) < 0;
+    }
+
+
+    inline bool string_sort_less(const std::string& a, const std::string& b, long depth)
+    {
+        return a.compare(depth, std::string::npos, b, depth, std::string::npos) < 0;
+    }
+} // namespace algorithm
+
+#endif // STRINGSORT_H
@@ -0,0 +1,456 @@
+/*
+# Copyright (c) 2008 Chung Shin Yee <cshinyee@gmail.com>
+#
+#       http://github.com/xman
+#       http://myxman.org
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License as
+# published by the Free Software Foundation; either version 2 of the
+# License, or (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+# USA.
+#
+# The GNU General Public License is contained in the file COPYING.
+#
+*/
+
+#ifndef TIMSORT_H
+#define TIMSORT_H
+
+#include <cassert>
+#include <algorithm>
+#include <vector>
+#include "insertionsort.h"
+#include "move.h"
+
+namespace algorithm
+{
+    /// \brief Sort the \b length elements using the Timsort algorithm with the Powersort merge policy.
+    /// \param T The data type of the elements.
+    /// \param[in,out] data The pointer to the list of elements.
+    /// \param[in] length The number of elements.
+    /// \note The sort is stable, and takes O(n) time on input made of few sorted runs.
+    template <typename T>
+    void tim_sort(T* data, long length);
+
+    /// \brief Sort the elements from \b istart to \b iend using the Timsort algorithm with the
+    ///        Powersort merge policy.
+    /// \param T The data type of the elements.
+    /// \param[in,out] data The pointer to the list of elements.
+    /// \param[in] istart The index of the first elements to sort.
+    /// \param[in] iend The index of the last elements to sort.
+    template <typename T>
+    void tim_sort(T* data, long istart, long iend);
+} // namespace algorithm
+
+
+// ===================================================================
+// Implementation
+// ===================================================================
+
+namespace algorithm
+{
+    /// The initial number of consecutive wins of one run that switches a merge to galloping.
+    static const long tim_sort_min_gallop = 7;
+
+
+    /// \brief A run waiting to be merged.
+    typedef struct {
+        long start; ///< The index of the first element.
+        long length; ///< The number of elements.
+        int power; ///< The power of the boundary between this run and the next one.
+    } TimSortRun;
+
+
+    template <typename T>
+    static long tim_sort_count_run(T* data, long istart, long length);
+
+    static long tim_sort_min_run(long length);
+
+    static int tim_sort_power(long s1, long n1, long n2, long n);
+
+    template <typename T>
+    static long gallop_left(const T& key, const T* a, long n, long hint);
+
+    template <typename T>
+    static long gallop_right(const T& key, const T* a, long n, long hint);
+
+    template <typename T>
+    static void tim_sort_merge(T* a, long na, long nb, T* buffer, long* min_gallop);
+
+    template <typename T>
+    static void tim_sort_merge_lo(T* a, long na, T* b, long nb, T* buffer, long* min_gallop);
+
+    template <typename T>
+    static void tim_sort_merge_hi(T* a, long na, T* b, long nb, T* buffer, long* min_gallop);
+
+
+    template <typename T>
+    void tim_sort(T* data, long length)
+    {
+        assert(length > 0);
+
+        tim_sort(data, 0, length-1);
+    }
+
+
+    /// Natural runs are ascending or strictly descending, the latter reversed in place.
+    /// Runs shorter than minrun are extended by Insertion Sort. Each new run gets the power
+    /// of its boundary with the previous run, the depth of that boundary in a nearly-optimal
+    /// merge tree, and the runs above a boundary of higher power are merged first.
+    /// \par References:
+    /// \li T. Peters. listsort.txt, CPython, 2002.
+    /// \li J. I. Munro and S. Wild. Nearly-Optimal Mergesorts: Fast, Practical Sorting Methods That
+    ///     Optimally Adapt to Existing Runs. ESA 2018.
+    template <typename T>
+    void tim_sort(T* data, long istart, long iend)
+    {
+        assert(iend - istart + 1 > 0);
+
+        long n = iend - istart + 1;
+        long min_run = tim_sort_min_run(n);
+        long min_gallop = tim_sort_min_gallop;
+        T* base = data + istart;
+        T* buffer = NULL;
+        std::vector<TimSortRun> stack;
+
+        for (long start = 0; start < n; ) {
+            long length = tim_sort_count_run(base, start, n - start);
+            if (length < min_run) {
+                long extended = std::min(min_run, n - start);
+                insertion_sort(base, start, start + extended - 1);
+                length = extended;
+            }
+
+            if (!stack.empty()) {
+                TimSortRun& top = stack.back();
+                int power = tim_sort_power(top.start, top.length, length, n);
+                while (stack.size() > 1 && stack[stack.size()-2].power > power) {
+                    if (buffer == NULL) {
+                        buffer = new T[n/2 + 1];
+                        assert(buffer != NULL);
+                    }
+                    TimSortRun& a = stack[stack.size()-2];
+                    TimSortRun& b = stack.back();
+                    tim_sort_merge(base + a.start, a.length, b.length, buffer, &min_gallop);
+                    a.length += b.length;
+                    stack.pop_back();
+                }
+                stack.back().power = power;
+            }
+
+            TimSortRun run = { start, length, 0 };
+            stack.push_back(run);
+            start += length;
+        }
+
+        while (stack.size() > 1) {
+            if (buffer == NULL) {
+                buffer = new T[n/2 + 1];
+                assert(buffer != NULL);
+            }
+            TimSortRun& a = stack[stack.size()-2];
+            TimSortRun& b = stack.back();
+            tim_sort_merge(base + a.start, a.length, b.length, buffer, &min_gallop);
+            a.length += b.length;
+            stack.pop_back();
+        }
+
+        delete[] buffer;
+    }
+
+
+    /// Get the length of the run at \b istart, reversing it if it is strictly descending.
+    template <typename T>
+    long tim_sort_count_run(T* data, long istart, long length)
+    {
+        T* a = data + istart;
+        long i = 1;
+
+        if (length < 2) {
+            return length;
+        }
+        if (a[1] < a[0]) {
+            while (i < length && a[i] < a[i-1]) {
+                i++;
+            }
+            std::reverse(a, a + i);
+        } else {
+            while (i < length && !(a[i] < a[i-1])) {
+                i++;
+            }
+        }
+        return i;
+    }
+
+
+    /// Pick a minimum run length in [32, 64] such that n / minrun is a power of two or
+    /// slightly less, so the final merges are balanced.
+    inline long tim_sort_min_run(long length)
+    {
+        long r = 0;
+        while (length >= 64) {
+            r |= length & 1;
+            length >>= 1;
+        }
+        return length + r;
+    }
+
+
+    /// The power of the boundary between the runs [s1, s1+n1) and [s1+n1, s1+n1+n2) of
+    /// an array of \b n elements: the first bit where the binary fractions of the two run
+    /// midpoints, divided by n, differ.
+    inline int tim_sort_power(long s1, long n1, long n2, long n)
+    {
+        long a = 2*s1 + n1;
+        long b = a + n1 + n2;
+        int power = 0;
+
+        for (;;) {
+            power++;
+            if (a >= n) {
+                a -= n;
+                b -= n;
+            } else if (b >= n) {
+                break;
+            }
+            a <<= 1;
+            b <<= 1;
+        }
+        return power;
+    }
+
+
+    /// Find the leftmost position to insert \b key in the sorted \b a, searching
+    /// exponentially outwards from \b hint, then by bisection.
+    /// \return k such that a[k-1] < key <= a[k].
+    template <typename T>
+    long gallop_left(const T& key, const T* a, long n, long hint)
+    {
+        long last = 0;
+        long ofs = 1;
+
+        if (a[hint] < key) {
+            long max = n - hint;
+            while (ofs < max && a[hint + ofs] < key) {
+                last = ofs;
+                ofs = 2*ofs + 1;
+            }
+            ofs = std::min(ofs, max);
+            last += hint;
+            ofs += hint;
+        } else {
+            long max = hint + 1;
+            while (ofs < max && !(a[hint - ofs] < key)) {
+                last = ofs;
+                ofs = 2*ofs + 1;
+            }
+            ofs = std::min(ofs, max);
+            long k = last;
+            last = hint - ofs;
+            ofs = hint - k;
+        }
+
+        // a[last] < key <= a[ofs]
+        last++;
+        while (last < ofs) {
+            long m = last + (ofs - last) / 2;
+            if (a[m] < key) {
+                last = m + 1;
+            } else {
+                ofs = m;
+            }
+        }
+        return ofs;
+    }
+
+
+    /// Find the rightmost position to insert \b key in the sorted \b a, searching
+    /// exponentially outwards from \b hint, then by bisection.
+    /// \return k such that a[k-1] <= key < a[k].
+    template <typename T>
+    long gallop_right(const T& key, const T* a, long n, long hint)
+    {
+        long last = 0;
+        long ofs = 1;
+
+        if (key < a[hint]) {
+            long max = hint + 1;
+            while (ofs < max && key < a[hint - ofs]) {
+                last = ofs;
+                ofs = 2*ofs + 1;
+            }
+            ofs = std::min(ofs, max);
+            long k = last;
+            last = hint - ofs;
+            ofs = hint - k;
+        } else {
+            long max = n - hint;
+            while (ofs < max && !(key < a[hint + ofs])) {
+                last = ofs;
+                ofs = 2*ofs + 1;
+            }
+            ofs = std::min(ofs, max);
+            last += hint;
+            ofs += hint;
+        }
+
+        // a[last] <= key < a[ofs]
+        last++;
+        while (last < ofs) {
+            long m = last + (ofs - last) / 2;
+            if (key < a[m]) {
+                ofs = m;
+            } else {
+                last = m + 1;
+            }
+        }
+        return ofs;
+    }
+
+
+    /// Merge the adjacent runs a[0..na) and a[na..na+nb). The elements of the first run
+    /// already in place and those of the second run already in place are skipped, then
+    /// the shorter remainder is copied to \b buffer.
+    template <typename T>
+    void tim_sort_merge(T* a, long na, long nb, T* buffer, long* min_gallop)
+    {
+        T* b = a + na;
+
+        long k = gallop_right(b[0], a, na, 0L);
+        a += k;
+        na -= k;
+        if (na == 0) {
+            return;
+        }
+        nb = gallop_left(a[na-1], b, nb, nb-1);
+        if (nb == 0) {
+            return;
+        }
+
+        if (na <= nb) {
+            tim_sort_merge_lo(a, na, b, nb, buffer, min_gallop);
+        } else {
+            tim_sort_merge_hi(a, na, b, nb, buffer, min_gallop);
+        }
+    }
+
+
+    /// Merge left to right with the first run in \b buffer. After \b min_gallop consecutive
+    /// wins of one run, whole stretches are located by galloping and copied at once; the
+    /// threshold drops while galloping pays off and rises when it stops paying off.
+    template <typename T>
+    void tim_sort_merge_lo(T* a, long na, T* b, long nb, T* buffer, long* min_gallop)
+    {
+        move_forward(a, a + na, buffer);
+        T* pa = buffer;
+        T* pb = b;
+        T* dest = a;
+
+        while (na > 0 && nb > 0) {
+            long acount = 0;
+            long bcount = 0;
+            while (na > 0 && nb > 0 && acount < *min_gallop && bcount < *min_gallop) {
+                if (*pb < *pa) {
+                    *dest++ = ALGORITHM_MOVE(*pb++);
+                    nb--;
+                    bcount++;
+                    acount = 0;
+                } else {
+                    *dest++ = ALGORITHM_MOVE(*pa++);
+                    na--;
+                    acount++;
+                    bcount = 0;
+                }
+            }
+
+            while (na > 0 && nb > 0) {
+                acount = gallop_right(*pb, pa, na, 0L);
+                dest = move_forward(pa, pa + acount, dest);
+                pa += acount;
+                na -= acount;
+                if (na == 0) {
+                    break;
+                }
+                bcount = gallop_left(*pa, pb, nb, 0L);
+                dest = move_forward(pb, pb + bcount, dest);
+                pb += bcount;
+                nb -= bcount;
+                if (nb == 0) {
+                    break;
+                }
+                if (acount < tim_sort_min_gallop && bcount < tim_sort_min_gallop) {
+                    (*min_gallop)++;
+                    break;
+                }
+                if (*min_gallop > 1) {
+                    (*min_gallop)--;
+                }
+            }
+        }
+
+        // What is left of the second run is already in place.
+        move_forward(pa, pa + na, dest);
+    }
+
+
+    /// Merge right to left with the second run in \b buffer, galloping as tim_sort_merge_lo().
+    template <typename T>
+    void tim_sort_merge_hi(T* a, long na, T* b, long nb, T* buffer, long* min_gallop)
+    {
+        move_forward(b, b + nb, buffer);
+        T* dest = b + nb;
+
+        while (na > 0 && nb > 0) {
+            long acount = 0;
+            long bcount = 0;
+            while (na > 0 && nb > 0 && acount < *min_gallop && bcount < *min_gallop) {
+                if (buffer[nb-1] < a[na-1]) {
+                    *--dest = ALGORITHM_MOVE(a[--na]);
+                    acount++;
+                    bcount = 0;
+                } else {
+                    *--dest = ALGORITHM_MOVE(buffer[--nb]);
+                    bcount++;
+                    acount = 0;
+                }
+            }
+
+            while (na > 0 && nb > 0) {
+                acount = na - gallop_right(buffer[nb-1], a, na, na-1);
+                dest = move_backward(a + na - acount, a + na, dest);
+                na -= acount;
+                if (na == 0) {
+                    break;
+                }
+                bcount = nb - gallop_left(a[na-1], buffer, nb, nb-1);
+                dest = move_backward(buffer + nb - bcount, buffer + nb, dest);
+                nb -= bcount;
+                if (nb == 0) {
+                    break;
+                }
+                if (acount < tim_sort_min_gallop && bcount < tim_sort_min_gallop) {
+                    (*min_gallop)++;
+                    break;
+                }
+                if (*min_gallop > 1) {
+                    (*min_gallop)--;
+                }
+            }
+        }
+
+        // What is left of the first run is already in place.
+        move_backward(buffer, buffer + nb, dest);
+    }
+} // namespace algorithm
+
+#endif // TIMSORT_H
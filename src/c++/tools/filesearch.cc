@@ -0,0 +1,158 @@
+/*
+# Copyright (c) 2008 Chung Shin Yee <cshinyee@gmail.com>
+#
+#       http://github.com/xman
+#       http://myxman.org
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License as
+# published by the Free Software Foundation; either version 2 of the
+# License, or (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+# USA.
+#
+# The GNU General Public License is contained in the file COPYING.
+#
+*/
+
+// filesearch - search files for a fixed string through memory mappings.
+//
+// Usage: filesearch [-c] [-w window_mb] pattern file...
+//
+//   Prints "file:offset" for every occurrence of pattern, overlapping ones included, or
+//   "file:count" with -c. A summary of every file, with its throughput, goes to stderr.
+//   Files are mapped window_mb megabytes at a time, 1024 by default, with MADV_SEQUENTIAL.
+//   The exit status is 0 if some occurrence is found, 1 if none, 2 on an error.
+//
+// Build: make filesearch
+
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/mman.h>
+#include "mappedfile.h"
+#include "stringsearch.h"
+#include "walltime.h"
+
+using namespace algorithm;
+
+
+/// \brief Print and count the occurrences starting in the window of a file.
+class Report
+{
+public:
+    Report(const char* path, long offset, long limit, bool print, long* count) :
+        m_path(path), m_offset(offset), m_limit(limit), m_print(print), m_count(count)
+    {
+    }
+
+    void operator()(long offset)
+    {
+        if (offset >= m_limit) {
+            return;
+        }
+        if (m_print) {
+            printf("%s:%ld\n", m_path, m_offset + offset);
+        }
+        (*m_count)++;
+    }
+
+private:
+    const char* m_path; ///< The path of the file.
+    long m_offset; ///< The position of the window in the file.
+    long m_limit; ///< The occurrences starting from here belong to the next window.
+    bool m_print; ///< Print the occurrences, or only count them?
+    long* m_count; ///< The number of occurrences in the file.
+};
+
+
+/// Each window is mapped with the length of the pattern minus one bytes more, so the
+/// occurrences starting near its end are found in it, and not again in the next window.
+static bool search_file(const StringSearch& search, const char* path, long window, bool print,
+                        long* count, long* bytes)
+{
+    MappedFile file;
+    long offset = 0;
+
+    *count = 0;
+    do {
+        if (!file.open(path, offset, window + search.length() - 1)) {
+            return false;
+        }
+        file.advise(MADV_SEQUENTIAL);
+        search.find_all(file.data(), file.size(), Report(path, offset, window, print, count));
+        offset += window;
+    } while (offset < file.file_size());
+
+    *bytes = file.file_size();
+    return true;
+}
+
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: filesearch [-c] [-w window_mb] pattern file...\n");
+    exit(2);
+}
+
+
+int main(int argc, char** argv)
+{
+    bool print = true;
+    long window = 1024;
+    int i = 1;
+
+    for (; i < argc && argv[i][0] == '-'; i++) {
+        if (strcmp(argv[i], "-c") == 0) {
+            print = false;
+        } else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+            window = atol(argv[++i]);
+            if (window <= 0 || window > (LONG_MAX >> 20)) {
+                usage();
+            }
+        } else {
+            usage();
+        }
+    }
+    if (argc - i < 2 || argv[i][0] == '\0') {
+        usage();
+    }
+
+    const char* pattern = argv[i++];
+    StringSearch search(pattern, static_cast<long>(strlen(pattern)));
+    window <<= 20;
+
+    int status = 1;
+    for (; i < argc; i++) {
+        long count, bytes;
+        WallTime t1 = get_wall_time();
+        if (!search_file(search, argv[i], window, print, &count, &bytes)) {
+            perror(argv[i]);
+            status = 2;
+            continue;
+        }
+        double seconds = elapsed_time(t1, get_wall_time());
+
+        if (!print) {
+            printf("%s:%ld\n", argv[i], count);
+        }
+        fprintf(stderr, "%s: %ld matches in %ld bytes, %.2f s", argv[i], count, bytes, seconds);
+        if (seconds > 0) {
+            fprintf(stderr, ", %.1f MB/s", bytes / seconds / 1e6);
+        }
+        fprintf(stderr, "\n");
+        if (count > 0 && status == 1) {
+            status = 0;
+        }
+    }
+    return status;
+}